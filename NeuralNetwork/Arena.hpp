@@ -0,0 +1,136 @@
+#ifndef TOOLBOX_NEURALNETWORK_ARENA_HPP
+#define TOOLBOX_NEURALNETWORK_ARENA_HPP
+
+/*
+ * Toolbox/NeuralNetwork/Arena.hpp
+ *
+ * A pool of memory for neurons (and their connections) to share.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - An Arena hands out memory from a few large blocks instead of going to
+ *   the heap for every neuron, dendrite and axon.  Everything allocated from
+ *   one arena ends up packed together in the order it was created, and it is
+ *   all given back at once when the arena goes away.
+ *
+ * - Memory given back to an arena (a removed dendrite, for example) isn't
+ *   reused until the whole arena is freed.  Arenas suit networks that are
+ *   built once and then used (or thrown away) as a whole, rather than ones
+ *   that are rewired over and over.
+ *
+ * - Ganglia use one after tGanglion<>::UseArena() (and GetArena() returns
+ *   it -- see Ganglion.hpp).  Each neuron allocated from an arena (through
+ *   tArenaAllocator<>) keeps the arena alive, so neurons can safely outlive
+ *   the ganglion that made them.
+ *
+ * - Arenas aren't thread safe.  Neurons sharing an arena should only be
+ *   created, connected and destroyed from one thread at a time (the same as
+ *   the ganglion they belong to).
+ *
+ ****************************************************************************
+	Toolbox::NeuralNetwork::Arena::Ptr Memory = std::make_shared< Toolbox::NeuralNetwork::Arena >();
+
+	// The neuron, its shared_ptr bookkeeping, and its dendrites and axons all come from the arena
+	Neuron::Ptr MyNeuron = std::allocate_shared< Neuron >( Toolbox::NeuralNetwork::tArenaAllocator<Neuron>(Memory), 0.0, Memory->Resource() );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+#include <Toolbox/Defines.h>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		class Arena
+		{
+		public:
+			TOOLBOX_POINTERS( Arena )
+
+		public:
+			Arena()
+			{
+			}
+
+			Arena( const Arena & ) = delete;
+			Arena &operator=( const Arena & ) = delete;
+
+			virtual ~Arena()
+			{
+			}
+
+			// For containers (std::pmr::map, etc.) to allocate from
+			std::pmr::memory_resource *Resource()
+			{
+				return &_Pool;
+			}
+
+		protected:
+			std::pmr::monotonic_buffer_resource	_Pool;
+		};
+
+
+		// Allocates from an Arena, and keeps it alive for as long as anything allocated through us (or a copy of us) is around
+		template <typename tType>
+		class tArenaAllocator
+		{
+		public:
+			typedef tType		value_type;
+
+			template <typename tOther> friend class tArenaAllocator;
+
+		public:
+			tArenaAllocator( const Arena::Ptr &arena ):
+				_Arena( arena )
+			{
+			}
+
+			template <typename tOther>
+			tArenaAllocator( const tArenaAllocator<tOther> &other ):
+				_Arena( other._Arena )
+			{
+			}
+
+			tType *allocate( std::size_t count )
+			{
+				return static_cast< tType * >( _Arena->Resource()->allocate(count * sizeof(tType), alignof(tType)) );
+			}
+
+			void deallocate( tType *pointer, std::size_t count )
+			{
+				_Arena->Resource()->deallocate( pointer, count * sizeof(tType), alignof(tType) );
+			}
+
+			template <typename tOther>
+			bool operator==( const tArenaAllocator<tOther> &rhs ) const
+			{
+				return _Arena == rhs._Arena;
+			}
+
+			template <typename tOther>
+			bool operator!=( const tArenaAllocator<tOther> &rhs ) const
+			{
+				return _Arena != rhs._Arena;
+			}
+
+		protected:
+			Arena::Ptr			_Arena;
+		};
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_ARENA_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
@@ -0,0 +1,806 @@
+#ifndef TOOLBOX_NEURALNETWORK_COMPILED_HPP
+#define TOOLBOX_NEURALNETWORK_COMPILED_HPP
+
+/*
+ * Toolbox/NeuralNetwork/Compiled.hpp
+ *
+ * A flattened, dense-layer execution engine for connected ganglia.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - A compiled ganglion is a snapshot of a connected, layered tGanglion<>
+ *   (Input -> Hidden... -> Output, plus the BiasNeuron) stored as contiguous
+ *   per-layer weight matrices and value vectors.  Processing it is a plain
+ *   matrix-vector forward pass with no pointer chasing.  Each layer is
+ *   activated with a single call to the nucleus' ActivateLayer(), which can
+ *   be vectorized (see Vectorized.hpp).
+ *
+ * - The neuron graph remains the editable source of truth.  Any changes made
+ *   to the ganglion after compiling (new neurons, new weights, etc.) are not
+ *   seen by the compiled copy until it is compiled again.
+ *
+ * - Weights are stored row-major per layer (one row per neuron, one column
+ *   per neuron of the previous layer, in the same order as the ganglion's
+ *   maps).  Connections that don't exist in the graph are stored as zero.
+ *
+ * - Processing follows the same rules as tGanglion<>::Process(), including
+ *   thresholds (when the ganglion isn't using a bias) and the processing
+ *   cycle limit.  The only difference is the order in which each neuron's
+ *   weighted inputs are summed (the graph sums in dendrite pointer order), so
+ *   results match to within floating point rounding.
+ *
+ * - ProcessBatch() runs many records through the network at once, with each
+ *   layer done as a single matrix-matrix product.  Networks using thresholds
+ *   carry state from one pass to the next, so they are still processed one
+ *   record at a time (in order).
+ *
+ * - The weights (Layers) and everything that changes from pass to pass
+ *   (State) are kept apart.  Process( state ) never touches anything but the
+ *   state it is given, so several threads can each run their own passes
+ *   through the same compiled network at once.
+ *
+ * - A ganglion's SoftmaxOutput comes along with it.  The output layer's
+ *   weighted sums (which are kept in the state anyway) then go straight
+ *   through the softmax as a whole, in place of the nucleus' ActivateLayer(),
+ *   both for single passes and for each record of a batch.
+ *
+ * - Export() copies the weights back into the ganglion they were compiled
+ *   from, so a compiled copy can be trained and the results kept.
+ *
+ * - Load() reads a network file (see tGanglion<>::Save()) straight into
+ *   compiled form, without building the neuron graph at all.  This is the
+ *   quickest way to bring up a trained network that only needs to be run.
+ *
+ * - Only layered topologies can be compiled.  Dendrites that reach anywhere
+ *   other than the previous layer or the BiasNeuron (recurrent/skip
+ *   connections) cause Compile() to throw.  Layered() checks a network
+ *   beforehand, without throwing.
+ *
+ * - Recurrent neurons (see Recurrent.hpp) can't be compiled either -- There's
+ *   nowhere to keep their memory, so the results would be those of some other
+ *   network.  Compile() throws for them, and Layered() says no.
+ *
+ ****************************************************************************
+	Ganglion MyGanglion;
+	// ... Create, connect and train the network as usual ...
+
+	// Flatten the network
+	Ganglion::ttCompiledGanglion Compiled = MyGanglion.Compile();
+
+	// Then use it just like the ganglion itself
+	Compiled.SetInput( "Input 1", 1.0 );
+	Compiled.SetInput( "Input 2", 0.0 );
+	Compiled.Process();
+
+	double Output = Compiled.GetOutput( "Output" );
+
+	// Or score a whole batch of records at once (row-major, columns in InputLabels order)
+	std::vector< double > Inputs = { 0.0, 0.0,
+									 1.0, 0.0,
+									 0.0, 1.0 };
+	std::vector< double > Outputs;			// Filled with 3 rows, columns in OutputLabels order
+	Compiled.ProcessBatch( Inputs, Outputs );
+
+	// Weights changed in the compiled copy (by training, etc.) can be copied back into the network
+	Compiled.Export( MyGanglion );
+
+	// Or skip the ganglion entirely for a network saved earlier
+	Ganglion::ttCompiledGanglion Loaded;
+	Loaded.Load( "xor.net" );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <Toolbox/NeuralNetwork/MappedFile.hpp>
+#include <Toolbox/NeuralNetwork/NetworkFile.hpp>
+#include <Toolbox/NeuralNetwork/Neuron.hpp>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		namespace Default
+		{
+			const size_t MaxProcessingCycles	= 100000;
+		}
+
+
+		template <typename _tNeuron = Neuron>
+		class tCompiledGanglion
+		{
+		public:
+			typedef _tNeuron									ttNeuron;
+			typedef typename ttNeuron::tNeurotransmitter		tNeurotransmitter;
+			typedef tCompiledGanglion< ttNeuron >				ttCompiledGanglion;
+
+			TOOLBOX_POINTERS( ttCompiledGanglion )
+
+			typedef std::vector< tNeurotransmitter >			tValues;
+			typedef std::vector< unsigned char >				tFlags;
+
+			// A single layer of hidden/output neurons -- Everything here stays fixed from pass to pass
+			struct tLayer
+			{
+				size_t			NumInputs;		// Width of the previous layer
+				size_t			NumNeurons;
+
+				tValues			Weights;		// Row-major, NumNeurons x NumInputs
+				tValues			Bias;			// The weight of the BiasNeuron for each neuron (zero if not connected)
+				tValues			Threshold;
+				tFlags			Connected;		// Row-major, NumNeurons x NumInputs -- Which weights actually exist in the network
+				tFlags			BiasConnected;	// Which neurons are connected to the BiasNeuron
+
+				tLayer():
+					NumInputs( 0 ),
+					NumNeurons( 0 )
+				{
+				}
+			};
+
+			typedef std::vector< tLayer >						tLayers;
+
+			// Everything that changes during a pass, kept apart from the weights so several passes can share one network (one state per thread)
+			struct tState
+			{
+				tValues					Input;
+				std::vector< tValues >	Sum;			// Per layer -- Weighted input sums from the last pass
+				std::vector< tValues >	Value;			// Per layer -- Activated values
+				std::vector< tFlags >	Activated;		// Per layer
+				std::vector< tFlags >	Fired;			// Per layer -- Activated during the current pass
+			};
+
+		public:
+			std::vector< std::string >	InputLabels;		// In the same order as the ganglion's Input map
+			std::vector< std::string >	OutputLabels;		// In the same order as the ganglion's Output map
+
+			tLayers						Layers;				// Hidden layers (in order), followed by the output layer
+			tState						State;				// Used by Process(), SetInput(), GetOutput(), etc.
+
+			bool						UseBias;
+			bool						SoftmaxOutput;		// The output layer is a softmax over its sums (see tGanglion<>::SoftmaxOutput)
+			tNeurotransmitter			BiasValue;
+
+		public:
+			tCompiledGanglion():
+				UseBias( true ),
+				SoftmaxOutput( false ),
+				BiasValue( tNeurotransmitter(1) )
+			{
+			}
+
+			template <typename tGanglion>
+			tCompiledGanglion( const tGanglion &network ):
+				UseBias( true ),
+				SoftmaxOutput( false ),
+				BiasValue( tNeurotransmitter(1) )
+			{
+				Compile( network );
+			}
+
+			virtual ~tCompiledGanglion()
+			{
+			}
+
+			// Flattens a connected network -- Can be called again at any time to pick up changes to the network
+			template <typename tGanglion>
+			void Compile( const tGanglion &network )
+			{
+				InputLabels.clear();
+				OutputLabels.clear();
+				Layers.clear();
+
+				if ( !network.BiasNeuron )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Compile(): Network has no bias neuron." );
+
+				if ( tHasMemory<typename tGanglion::ttNeuron>::value )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Compile(): Recurrent networks can't be compiled (their memory would be left out)." );
+
+				UseBias = network.UseBias;
+				SoftmaxOutput = network.SoftmaxOutput;
+				BiasValue = network.BiasNeuron->Value();
+
+				if ( SoftmaxOutput && !UseBias )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Compile(): SoftmaxOutput needs a network using a bias." );
+
+				for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i )
+					InputLabels.push_back( i->first );
+
+				for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
+					OutputLabels.push_back( o->first );
+
+				tNeuronLayers NeuronLayers;
+				_gatherLayers( network, NeuronLayers );
+
+				for ( size_t l = 1, l_end = NeuronLayers.size(); l < l_end; ++l )
+				{
+					Layers.push_back( tLayer() );
+					tLayer &CurLayer = Layers.back();
+
+					CurLayer.NumInputs = NeuronLayers[ l - 1 ].size();
+					CurLayer.NumNeurons = NeuronLayers[ l ].size();
+					CurLayer.Weights.assign( CurLayer.NumInputs * CurLayer.NumNeurons, tNeurotransmitter() );
+					CurLayer.Bias.assign( CurLayer.NumNeurons, tNeurotransmitter() );
+					CurLayer.Threshold.assign( CurLayer.NumNeurons, tNeurotransmitter() );
+
+					CurLayer.Connected.assign( CurLayer.NumInputs * CurLayer.NumNeurons, false );
+					CurLayer.BiasConnected.assign( CurLayer.NumNeurons, false );
+
+					tNeuronIndex PrevLayer;
+					_indexLayer( NeuronLayers[l - 1], PrevLayer );
+
+					for ( size_t n = 0; n < CurLayer.NumNeurons; ++n )
+					{
+						auto CurNeuron = NeuronLayers[ l ][ n ];
+
+						if ( CurNeuron->Dendrites.empty() )
+							throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Compile(): Network is not connected." );
+
+						CurLayer.Threshold[ n ] = CurNeuron->Threshold;
+
+						for ( auto d = CurNeuron->Dendrites.begin(), d_end = CurNeuron->Dendrites.end(); d != d_end; ++d )
+						{
+							auto Dendrite = (d->first).lock();
+
+							if ( !Dendrite )
+								continue;
+
+							if ( Dendrite == network.BiasNeuron )
+							{
+								CurLayer.Bias[ n ] = d->second;
+								CurLayer.BiasConnected[ n ] = true;
+								continue;
+							}
+
+							size_t Prev = _findPrev( PrevLayer, Dendrite );
+
+							CurLayer.Weights[ (n * CurLayer.NumInputs) + Prev ] = d->second;
+							CurLayer.Connected[ (n * CurLayer.NumInputs) + Prev ] = true;
+						}
+					}
+				}
+
+				// Start off from wherever the network currently is
+				NewState( State );
+
+				for ( size_t i = 0, i_end = NeuronLayers[0].size(); i < i_end; ++i )
+					State.Input[ i ] = NeuronLayers[ 0 ][ i ]->Value();
+
+				for ( size_t l = 1, l_end = NeuronLayers.size(); l < l_end; ++l )
+				{
+					for ( size_t n = 0, n_end = NeuronLayers[l].size(); n < n_end; ++n )
+					{
+						State.Value[ l - 1 ][ n ] = NeuronLayers[ l ][ n ]->Value();
+						State.Activated[ l - 1 ][ n ] = NeuronLayers[ l ][ n ]->Activated();
+					}
+				}
+			}
+
+			// Whether Compile() would take the network -- Every neuron past the inputs is connected, and only to the previous layer or the BiasNeuron (and none of them are recurrent)
+			template <typename tGanglion>
+			static bool Layered( const tGanglion &network )
+			{
+				if ( !network.BiasNeuron || (network.SoftmaxOutput && !network.UseBias) || tHasMemory<typename tGanglion::ttNeuron>::value )
+					return false;
+
+				tNeuronLayers NeuronLayers;
+				_gatherLayers( network, NeuronLayers );
+
+				for ( size_t l = 1, l_end = NeuronLayers.size(); l < l_end; ++l )
+				{
+					tNeuronIndex PrevLayer;
+					_indexLayer( NeuronLayers[l - 1], PrevLayer );
+
+					for ( auto n = NeuronLayers[l].begin(), n_end = NeuronLayers[l].end(); n != n_end; ++n )
+					{
+						if ( (*n)->Dendrites.empty() )
+							return false;
+
+						for ( auto d = (*n)->Dendrites.begin(), d_end = (*n)->Dendrites.end(); d != d_end; ++d )
+						{
+							auto Dendrite = (d->first).lock();
+
+							if ( Dendrite && Dendrite != network.BiasNeuron && PrevLayer.find(Dendrite.get()) == PrevLayer.end() )
+								return false;
+						}
+					}
+				}
+
+				return true;
+			}
+
+			// Copies the weights (which may have been changed, by training for example) back into the network they were compiled from
+			template <typename tGanglion>
+			void Export( tGanglion &network ) const
+			{
+				tNeuronLayers NeuronLayers;
+				_gatherLayers( network, NeuronLayers );
+
+				if ( NeuronLayers.size() != Layers.size() + 1 )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Export(): Network does not match." );
+
+				for ( size_t l = 1, l_end = NeuronLayers.size(); l < l_end; ++l )
+				{
+					const tLayer &CurLayer = Layers[ l - 1 ];
+
+					if ( NeuronLayers[l].size() != CurLayer.NumNeurons || NeuronLayers[l - 1].size() != CurLayer.NumInputs )
+						throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Export(): Network does not match." );
+
+					tNeuronIndex PrevLayer;
+					_indexLayer( NeuronLayers[l - 1], PrevLayer );
+
+					for ( size_t n = 0; n < CurLayer.NumNeurons; ++n )
+					{
+						auto CurNeuron = NeuronLayers[ l ][ n ];
+
+						for ( auto d = CurNeuron->Dendrites.begin(), d_end = CurNeuron->Dendrites.end(); d != d_end; ++d )
+						{
+							auto Dendrite = (d->first).lock();
+
+							if ( !Dendrite )
+								continue;
+
+							if ( Dendrite == network.BiasNeuron )
+								d->second = CurLayer.Bias[ n ];
+							else
+								d->second = CurLayer.Weights[ (n * CurLayer.NumInputs) + _findPrev(PrevLayer, Dendrite) ];
+						}
+					}
+				}
+
+				network.Invalidate();
+			}
+
+			// Reads a network file (see tGanglion<>::Save()) directly into compiled form
+			void Load( const std::string &fileName )
+			{
+				MappedFile File( fileName );
+				NetworkFile::tHeader Header;
+				NetworkFile::ReadHeader( File.Data(), File.Size(), Header );
+
+				const unsigned char *Data = File.Data();
+				const size_t ValueSize = TrainingFile::ValueSize( Header.ValueType );
+
+				// Nothing is replaced until the whole file has been read, so a bad one leaves us as we were
+				tLayers Loaded;
+
+				const bool LoadedUseBias = ((Header.Flags & NetworkFile::UseBias) != 0);
+				const bool LoadedSoftmaxOutput = ((Header.Flags & NetworkFile::SoftmaxOutput) != 0);
+
+				if ( LoadedSoftmaxOutput && !LoadedUseBias )
+					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tCompiledGanglion<>::Load(): '") + fileName + std::string("' is corrupt.") );
+
+				// Where each layer starts in the file's neuron numbering (the BiasNeuron is number 0)
+				std::vector< size_t > LayerStart( 1, 1 );
+				LayerStart.push_back( LayerStart.back() + Header.InputLabels.size() );
+
+				for ( auto l = Header.HiddenLayers.begin(), l_end = Header.HiddenLayers.end(); l != l_end; ++l )
+					LayerStart.push_back( LayerStart.back() + l->Neurons.size() );
+
+				LayerStart.push_back( LayerStart.back() + Header.OutputLabels.size() );
+
+				for ( size_t l = 1, l_end = LayerStart.size() - 1; l < l_end; ++l )
+				{
+					Loaded.push_back( tLayer() );
+					tLayer &CurLayer = Loaded.back();
+
+					const size_t PrevStart = LayerStart[ l - 1 ];
+
+					CurLayer.NumInputs = LayerStart[ l ] - PrevStart;
+					CurLayer.NumNeurons = LayerStart[ l + 1 ] - LayerStart[ l ];
+					CurLayer.Weights.assign( CurLayer.NumInputs * CurLayer.NumNeurons, tNeurotransmitter() );
+					CurLayer.Bias.assign( CurLayer.NumNeurons, tNeurotransmitter() );
+					CurLayer.Threshold.assign( CurLayer.NumNeurons, tNeurotransmitter() );
+
+					CurLayer.Connected.assign( CurLayer.NumInputs * CurLayer.NumNeurons, false );
+					CurLayer.BiasConnected.assign( CurLayer.NumNeurons, false );
+
+					for ( size_t n = 0; n < CurLayer.NumNeurons; ++n )
+					{
+						const size_t Number = LayerStart[ l ] + n;
+
+						if ( Header.FirstDendrite[Number] == Header.FirstDendrite[Number + 1] )
+							throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Load(): Network is not connected." );
+
+						CurLayer.Threshold[ n ] = TrainingFile::ReadValue< tNeurotransmitter >( Data + Header.ThresholdOffset() + (Number * ValueSize), Header.ValueType );
+
+						for ( uint64_t d = Header.FirstDendrite[Number], d_end = Header.FirstDendrite[Number + 1]; d < d_end; ++d )
+						{
+							const size_t Source = Header.Source[ d ];
+							tNeurotransmitter Weight = TrainingFile::ReadValue< tNeurotransmitter >( Data + Header.WeightOffset() + (d * ValueSize), Header.ValueType );
+
+							if ( Source == 0 )
+							{
+								CurLayer.Bias[ n ] = Weight;
+								CurLayer.BiasConnected[ n ] = true;
+								continue;
+							}
+
+							if ( Source < PrevStart || Source >= LayerStart[l] )
+								throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Load(): Unsupported topology (only layered networks can be compiled)." );
+
+							CurLayer.Weights[ (n * CurLayer.NumInputs) + (Source - PrevStart) ] = Weight;
+							CurLayer.Connected[ (n * CurLayer.NumInputs) + (Source - PrevStart) ] = true;
+						}
+					}
+				}
+
+				InputLabels = Header.InputLabels;
+				OutputLabels = Header.OutputLabels;
+				Layers.swap( Loaded );
+
+				UseBias = LoadedUseBias;
+				SoftmaxOutput = LoadedSoftmaxOutput;
+				BiasValue = TrainingFile::ReadValue< tNeurotransmitter >( Data + Header.DataOffset + ValueSize, Header.ValueType );
+
+				NewState( State );
+			}
+
+			// Sizes a state to match this network (everything zeroed out)
+			void NewState( tState &state ) const
+			{
+				state.Input.assign( InputLabels.size(), tNeurotransmitter() );
+				state.Sum.resize( Layers.size() );
+				state.Value.resize( Layers.size() );
+				state.Activated.resize( Layers.size() );
+				state.Fired.resize( Layers.size() );
+
+				for ( size_t l = 0, l_end = Layers.size(); l < l_end; ++l )
+				{
+					state.Sum[ l ].assign( Layers[l].NumNeurons, tNeurotransmitter() );
+					state.Value[ l ].assign( Layers[l].NumNeurons, tNeurotransmitter() );
+					state.Activated[ l ].assign( Layers[l].NumNeurons, false );
+					state.Fired[ l ].assign( Layers[l].NumNeurons, false );
+				}
+			}
+
+			size_t NumInputs() const
+			{
+				return InputLabels.size();
+			}
+
+			size_t NumOutputs() const
+			{
+				return OutputLabels.size();
+			}
+
+			size_t InputIndex( const std::string &label ) const
+			{
+				for ( size_t i = 0, i_end = InputLabels.size(); i < i_end; ++i )
+				{
+					if ( InputLabels[i] == label )
+						return i;
+				}
+
+				throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tCompiledGanglion<>::InputIndex(): Input '") + label + std::string("' not found.") );
+			}
+
+			size_t OutputIndex( const std::string &label ) const
+			{
+				for ( size_t o = 0, o_end = OutputLabels.size(); o < o_end; ++o )
+				{
+					if ( OutputLabels[o] == label )
+						return o;
+				}
+
+				throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tCompiledGanglion<>::OutputIndex(): Output '") + label + std::string("' not found.") );
+			}
+
+			void SetInput( const std::string &label, tNeurotransmitter value = tNeurotransmitter() )
+			{
+				State.Input[ InputIndex(label) ] = value;
+			}
+
+			void SetInput( size_t index, tNeurotransmitter value = tNeurotransmitter() )
+			{
+				if ( index >= State.Input.size() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::SetInput(): Index out of range." );
+
+				State.Input[ index ] = value;
+			}
+
+			// Same rules as tGanglion<>::Process() -- The inputs take the first processing cycle, and each layer takes another
+			virtual void Process( size_t maxProcessingCycles = Default::MaxProcessingCycles )
+			{
+				Process( State, maxProcessingCycles );
+			}
+
+			// Processes using the inputs (and previous values) from 'state' -- Safe to call from several threads at once, each with its own state
+			void Process( tState &state, size_t maxProcessingCycles = Default::MaxProcessingCycles ) const
+			{
+				// The inputs are always "processed" and always fire, as long as there are any
+				if ( state.Input.empty() )
+					return;
+
+				size_t CurCycle = 1;
+
+				for ( size_t l = 0, l_end = Layers.size(); l < l_end; ++l )
+				{
+					if ( maxProcessingCycles != 0 && CurCycle++ >= maxProcessingCycles )
+						break;
+
+					if ( !ProcessLayer(state, l) )
+						break;
+				}
+			}
+
+			// Processes just 'layer', from the inputs or the layer before it in 'state' -- Returns false when nothing in it fired (Process() stops there)
+			bool ProcessLayer( tState &state, size_t layer ) const
+			{
+				const tNeurotransmitter *PrevValue = (layer == 0 ? state.Input.data() : state.Value[layer - 1].data());
+				const unsigned char *PrevActivated = (UseBias || layer == 0 ? NULL : state.Activated[layer - 1].data());		// NULL == all activated
+				const unsigned char *PrevFired = (UseBias || layer == 0 ? NULL : state.Fired[layer - 1].data());				// NULL == all fired
+
+				return _processLayer( Layers[layer], state.Sum[layer], state.Value[layer], state.Activated[layer], state.Fired[layer], PrevValue, PrevActivated, PrevFired, SoftmaxOutput && layer + 1 == Layers.size() );
+			}
+
+			// Processes many records at once -- 'inputs' is row-major (numRecords x NumInputs(), in InputLabels order) and 'outputs' receives numRecords x NumOutputs() values (in OutputLabels order)
+			virtual void ProcessBatch( const tNeurotransmitter *inputs, size_t numRecords, tNeurotransmitter *outputs, size_t maxProcessingCycles = Default::MaxProcessingCycles )
+			{
+				if ( Layers.empty() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::ProcessBatch(): Network has not been compiled." );
+
+				const size_t NumIn = NumInputs();
+				const size_t NumOut = NumOutputs();
+
+				// Thresholds carry state from one pass to the next (as does cutting processing short), so those have to be done one record at a time
+				if ( !UseBias || NumIn == 0 || (maxProcessingCycles != 0 && maxProcessingCycles <= Layers.size()) )
+				{
+					for ( size_t r = 0; r < numRecords; ++r )
+					{
+						std::copy( inputs + (r * NumIn), inputs + ((r + 1) * NumIn), State.Input.begin() );
+						Process( maxProcessingCycles );
+						std::copy( State.Value.back().begin(), State.Value.back().end(), outputs + (r * NumOut) );
+					}
+
+					return;
+				}
+
+				// Otherwise, each layer is a single matrix-matrix product followed by a single activation call
+				const tNeurotransmitter *Prev = inputs;
+
+				for ( size_t l = 0, l_end = Layers.size(); l < l_end; ++l )
+				{
+					tLayer &CurLayer = Layers[ l ];
+					tValues &Buffer = _BatchBuffer[ l % 2 ];
+					tNeurotransmitter *Out = outputs;
+
+					if ( l + 1 != l_end )
+					{
+						Buffer.resize( numRecords * CurLayer.NumNeurons );
+						Out = Buffer.data();
+					}
+
+					_multiplyLayer( CurLayer, Prev, numRecords, Out );
+
+					if ( SoftmaxOutput && l + 1 == l_end )
+					{
+						for ( size_t r = 0; r < numRecords; ++r )
+							Activation::Softmax( Out + (r * CurLayer.NumNeurons), Out + (r * CurLayer.NumNeurons), CurLayer.NumNeurons );
+					}
+					else
+						ttNeuron::ActivateLayer( Out, Out, numRecords * CurLayer.NumNeurons );
+
+					Prev = Out;
+				}
+			}
+
+			void ProcessBatch( const tValues &inputs, tValues &outputs, size_t maxProcessingCycles = Default::MaxProcessingCycles )
+			{
+				if ( NumInputs() == 0 || (inputs.size() % NumInputs()) != 0 )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::ProcessBatch(): Input size is not a multiple of the number of inputs." );
+
+				size_t NumRecords = inputs.size() / NumInputs();
+				outputs.resize( NumRecords * NumOutputs() );
+
+				ProcessBatch( inputs.data(), NumRecords, outputs.data(), maxProcessingCycles );
+			}
+
+			tNeurotransmitter GetOutput( const std::string &label ) const
+			{
+				return Outputs()[ OutputIndex(label) ];
+			}
+
+			tNeurotransmitter GetOutput( size_t index ) const
+			{
+				if ( index >= Outputs().size() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::GetOutput(): Index out of range." );
+
+				return Outputs()[ index ];
+			}
+
+			// All of the output values, in OutputLabels order
+			const tValues &Outputs() const
+			{
+				if ( State.Value.empty() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Outputs(): Network has not been compiled." );
+
+				return State.Value.back();
+			}
+
+		protected:
+			typedef std::vector< std::vector<typename _Neuron<tNeurotransmitter>::Ptr> >	tNeuronLayers;
+			typedef std::map< const _Neuron<tNeurotransmitter> *, size_t >					tNeuronIndex;
+
+		protected:
+			tValues						_BatchBuffer[ 2 ];		// Hidden layer values during ProcessBatch() (reused between calls)
+
+		protected:
+			// Gathers up our neurons in processing order (input, hidden..., output)
+			template <typename tGanglion>
+			static void _gatherLayers( const tGanglion &network, tNeuronLayers &layers )
+			{
+				layers.clear();
+				layers.push_back( typename tNeuronLayers::value_type() );
+
+				for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i )
+					layers.back().push_back( i->second );
+
+				for ( auto l = network.Hidden.begin(), l_end = network.Hidden.end(); l != l_end; ++l )
+				{
+					layers.push_back( typename tNeuronLayers::value_type() );
+
+					for ( auto h = l->second.begin(), h_end = l->second.end(); h != h_end; ++h )
+						layers.back().push_back( h->second );
+				}
+
+				layers.push_back( typename tNeuronLayers::value_type() );
+
+				for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
+					layers.back().push_back( o->second );
+			}
+
+			static void _indexLayer( const typename tNeuronLayers::value_type &layer, tNeuronIndex &index )
+			{
+				index.clear();
+
+				for ( size_t n = 0, n_end = layer.size(); n < n_end; ++n )
+					index[ layer[n].get() ] = n;
+			}
+
+			static size_t _findPrev( const tNeuronIndex &prevLayer, const typename _Neuron<tNeurotransmitter>::Ptr &neuron )
+			{
+				auto Prev = prevLayer.find( neuron.get() );
+
+				if ( Prev == prevLayer.end() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tCompiledGanglion<>::Compile(): Unsupported topology (only layered networks can be compiled)." );
+
+				return Prev->second;
+			}
+
+			// A row of weights times a row of values, kept in DotLanes running sums that are added together (in a fixed order) at the end
+			//  - The compiler can keep the running sums in SIMD registers (which hold twice as many floats as doubles), and every pass (single or batched) still sums each row exactly the same way
+			static tNeurotransmitter _dot( const tNeurotransmitter *weight, const tNeurotransmitter *value, size_t count )
+			{
+				const size_t DotLanes = std::max< size_t >( 32 / sizeof(tNeurotransmitter), 1 );		// One AVX register's worth (or two SSE registers)
+				tNeurotransmitter Partial[ DotLanes ] = {};
+				size_t i = 0;
+
+				for ( ; i + DotLanes <= count; i += DotLanes )
+				{
+					for ( size_t l = 0; l < DotLanes; ++l )
+						Partial[ l ] += weight[i + l] * value[i + l];
+				}
+
+				for ( size_t l = 1; l < DotLanes; ++l )
+					Partial[ 0 ] += Partial[ l ];
+
+				for ( ; i < count; ++i )
+					Partial[ 0 ] += weight[ i ] * value[ i ];
+
+				return Partial[ 0 ];
+			}
+
+			// Weighted sums for a block of records -- Each record is summed in the same order as _processLayer(), so batches match single passes exactly
+			void _multiplyLayer( const tLayer &layer, const tNeurotransmitter *prevValue, size_t numRecords, tNeurotransmitter *sum ) const
+			{
+				const size_t NumInputs = layer.NumInputs;
+				const size_t NumNeurons = layer.NumNeurons;
+				const size_t BlockSize = 4;		// Records per block -- Each weight row is loaded once per block
+
+				size_t r = 0;
+
+				for ( ; r + BlockSize <= numRecords; r += BlockSize )
+				{
+					const tNeurotransmitter *x0 = prevValue + (r * NumInputs);
+					const tNeurotransmitter *x1 = x0 + NumInputs;
+					const tNeurotransmitter *x2 = x1 + NumInputs;
+					const tNeurotransmitter *x3 = x2 + NumInputs;
+					const tNeurotransmitter *Weight = layer.Weights.data();
+
+					for ( size_t n = 0; n < NumNeurons; ++n, Weight += NumInputs )
+					{
+						tNeurotransmitter Bias = layer.Bias[n] * BiasValue;
+
+						sum[ ((r + 0) * NumNeurons) + n ] = _dot( Weight, x0, NumInputs ) + Bias;
+						sum[ ((r + 1) * NumNeurons) + n ] = _dot( Weight, x1, NumInputs ) + Bias;
+						sum[ ((r + 2) * NumNeurons) + n ] = _dot( Weight, x2, NumInputs ) + Bias;
+						sum[ ((r + 3) * NumNeurons) + n ] = _dot( Weight, x3, NumInputs ) + Bias;
+					}
+				}
+
+				for ( ; r < numRecords; ++r )
+				{
+					const tNeurotransmitter *x = prevValue + (r * NumInputs);
+					const tNeurotransmitter *Weight = layer.Weights.data();
+
+					for ( size_t n = 0; n < NumNeurons; ++n, Weight += NumInputs )
+						sum[ (r * NumNeurons) + n ] = _dot( Weight, x, NumInputs ) + (layer.Bias[n] * BiasValue);
+				}
+			}
+
+			// Returns 'true' if any neuron in the layer fired (and the next layer should be processed) -- 'softmax' (only with a bias) activates the layer as a whole
+			bool _processLayer( const tLayer &layer, tValues &sum, tValues &value, tFlags &activated, tFlags &fired, const tNeurotransmitter *prevValue, const unsigned char *prevActivated, const unsigned char *prevFired, bool softmax = false ) const
+			{
+				const size_t NumInputs = layer.NumInputs;
+				const tNeurotransmitter *Weight = layer.Weights.data();
+
+				if ( UseBias )
+				{
+					// Everything fires, so this is a straight matrix-vector product
+					for ( size_t n = 0; n < layer.NumNeurons; ++n, Weight += NumInputs )
+						sum[ n ] = _dot( Weight, prevValue, NumInputs ) + (layer.Bias[n] * BiasValue);
+
+					if ( softmax )
+						Activation::Softmax( sum.data(), value.data(), layer.NumNeurons );
+					else
+						ttNeuron::ActivateLayer( sum.data(), value.data(), layer.NumNeurons );
+					std::fill( activated.begin(), activated.end(), true );
+					std::fill( fired.begin(), fired.end(), true );
+
+					return layer.NumNeurons != 0;
+				}
+
+				// Thresholds -- A neuron is only processed if something connected to it fired during this pass, and only sums up activated inputs
+				bool AnyFired = false;
+				const unsigned char *Connected = layer.Connected.data();
+
+				for ( size_t n = 0; n < layer.NumNeurons; ++n, Weight += NumInputs, Connected += NumInputs )
+				{
+					bool Queued = false;
+
+					for ( size_t i = 0; i < NumInputs && !Queued; ++i )
+						Queued = Connected[i] && (!prevFired || prevFired[i]);
+
+					fired[ n ] = false;
+
+					if ( !Queued )
+						continue;		// Keeps its value (and activation) from the last time it was processed
+
+					tNeurotransmitter Sum = tNeurotransmitter();
+
+					for ( size_t i = 0; i < NumInputs; ++i )
+					{
+						if ( !prevActivated || prevActivated[i] )
+							Sum += Weight[i] * prevValue[i];
+					}
+
+					sum[ n ] = Sum + (layer.Bias[n] * BiasValue);
+					ttNeuron::ActivateLayer( &sum[n], &value[n], 1 );
+					activated[ n ] = (value[n] >= layer.Threshold[n]);
+					fired[ n ] = activated[ n ];
+
+					AnyFired = AnyFired || fired[ n ];
+				}
+
+				return AnyFired;
+			}
+		};
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_COMPILED_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
@@ -18,6 +18,77 @@
  * - The Ganglion class provides a generic interface for manipulating a
  *   neural network as a whole unit.
  *
+ * - By default, every neuron (and each of its dendrites and axons) is a
+ *   separate heap allocation.  Calling UseArena() before adding any neurons
+ *   allocates them all from one pooled Arena instead (see Arena.hpp), which
+ *   keeps the network packed together in memory and makes tearing it down
+ *   nearly free -- Handy when building and throwing away many networks.
+ *
+ * - Save() writes the whole network (topology, thresholds and weights) to a
+ *   binary file, and Load() reads it back in (see NetworkFile.hpp).  Loading
+ *   into a network that is already put together the same way only copies the
+ *   thresholds and weights (straight out of the memory-mapped file), so a
+ *   trained network can be brought back up without retraining it.  Otherwise
+ *   the network is rebuilt to match the file first.
+ *
+ * - Process() follows a schedule worked out once for the network's shape
+ *   (by ConnectNetwork(), or by the first Process() after NewInput(),
+ *   NewOutput(), NewHiddenLayer() or Load() changes it).  Every neuron the
+ *   inputs can reach is put in order after everything feeding into it, so
+ *   each is processed at most once per pass, after all of its inputs.
+ *   Neurons that feed back into each other (recurrent loops) are grouped
+ *   together, and each group is gone over again and again until it settles
+ *   (or maxProcessingCycles runs out).  Only neurons with an input that fired
+ *   are processed, the same as always.  See ProcessingOrder.hpp.
+ *
+ * - The schedule belongs to the ganglion, so only its own functions know to
+ *   throw it out.  After connecting, disconnecting or replacing neurons by
+ *   hand (AddDendrite(), RemoveDendrite(), or editing Input, Output or
+ *   Hidden directly), call Reschedule() before the next Process().
+ *
+ * - maxProcessingCycles still counts "layers": the inputs take the first
+ *   cycle, and a neuron is reached in the cycle after its furthest input.
+ *   Layered networks work out exactly as they always have.
+ *
+ * - Neurons reached in the same processing cycle (a hidden layer, for
+ *   example) don't depend on each other, so after UseWorkerPool() each wide
+ *   enough level (ParallelWidth neurons or more) is split across the pool's
+ *   threads, and the next level waits for all of them.  Each neuron still
+ *   does exactly the same work, so the results are identical to processing
+ *   on one thread.  The nucleus' functions need to be safe to call from
+ *   several threads at once, and a pool should only be used by one ganglion
+ *   at a time.
+ *
+ * - Turning on Incremental reprocesses only what changed since the last
+ *   pass.  SetInput() leaves an input alone when given the value it already
+ *   has, and Process() then starts from the inputs that were set to
+ *   something new, following their axons only as far as values keep
+ *   changing -- Everything else keeps the value it worked out last time.
+ *   The outputs come out the same as processing everything, for a fraction
+ *   of the work when most inputs stay put from one pass to the next.
+ *
+ * - Incremental passes need a bias (networks using thresholds are always
+ *   processed in full), run on the calling thread, and go all the way around
+ *   any recurrent loops every time.  Changing weights or thresholds directly
+ *   needs an Invalidate() so the next pass starts over from scratch --
+ *   Load(), the trainers and Export() from compiled networks do this for
+ *   you.  tRecurrent<> networks always process everything, since their
+ *   memories move on every pass.
+ *
+ * - Setting SoftmaxOutput makes the outputs a softmax over their weighted
+ *   sums -- Each is exp( sum ) over the total for all of the outputs, so they
+ *   are all positive and add up to 1 (the usual way to pick one of several
+ *   classes).  It is worked out for the whole output layer at once at the
+ *   end of each Process(), relative to the largest sum so nothing overflows.
+ *   GetOutput() and GetOutputs() return the softmax (the output neurons
+ *   themselves keep their activated values), and the trainers train it
+ *   against cross-entropy (see Trainer.hpp).  Softmax outputs need a bias,
+ *   and aren't supported by tRecurrent<> networks.
+ *
+ * - With TOOLBOX_NEURALNETWORK_PROFILE defined, every Process() reports to
+ *   Profiler (when set) -- How long it took, the neurons processed and the
+ *   processing cycles used.  See Profile.hpp.
+ *
  ****************************************************************************
 	typedef Toolbox::NeuralNetwork::Ganglion		Ganglion; // a.k.a tGanglion< tNeuron<tNucleus<double>> >
 
@@ -30,6 +101,16 @@
 	MyGanglion->NewOutput( "Output" );
 	MyGanglion->ConnectNetwork();
 
+	// Optionally, a network can be allocated from an arena (before adding any neurons)
+	Ganglion ArenaGanglion;
+	ArenaGanglion.UseArena();
+
+	// Wide networks can process each layer across several threads
+	MyGanglion->UseWorkerPool( std::make_shared<Toolbox::NeuralNetwork::WorkerPool>(8) );
+
+	// Or, when only a few inputs change from one pass to the next, only reprocess what they reach
+	MyGanglion->Incremental = true;
+
 	// ... Train the network here ...
 	// See <Toolbox/NeuralNetwork/Trainer.hpp> for more info
 
@@ -43,20 +124,65 @@
 	// Finally, get our output from the network
 	double Output = MyGanglion->GetOutput( "Output" );
 
+	// Classifiers can have their outputs add up to 1 instead (set before training)
+	MyGanglion->SoftmaxOutput = true;
+
+	// All of the outputs at once, in label order
+	std::vector< double > Outputs;
+	MyGanglion->GetOutputs( Outputs );
+
+	// Fully-connected networks can also be flattened for faster processing
+	// See <Toolbox/NeuralNetwork/Compiled.hpp> for more info
+	Ganglion::ttCompiledGanglion Compiled = MyGanglion->Compile();
+
+	// Networks that aren't layered (or are only sparsely connected) can be flattened too
+	// See <Toolbox/NeuralNetwork/Sparse.hpp> for more info
+	Ganglion::ttSparseGanglion Sparse = MyGanglion->CompileSparse();
+
+	// Or many records can be processed at once (row-major, one column per input in label order)
+	// Recurrent networks use ProcessSequence() instead -- See <Toolbox/NeuralNetwork/Recurrent.hpp>
+	std::vector< double > Inputs = { 1.0, 0.0,   0.0, 1.0 }, Outputs;
+	MyGanglion->ProcessBatch( Inputs, Outputs );
+
+	// Keep the trained network around for next time
+	MyGanglion->Save( "xor.net" );
+
+	// ... Then later, in place of creating and training it again
+	Ganglion Loaded;
+	Loaded.Load( "xor.net" );
+
  ****************************************************************************/
 /****************************************************************************/
 
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <Toolbox/NeuralNetwork/Arena.hpp>
+#include <Toolbox/NeuralNetwork/Compiled.hpp>
+#include <Toolbox/NeuralNetwork/MappedFile.hpp>
+#include <Toolbox/NeuralNetwork/NetworkFile.hpp>
 #include <Toolbox/NeuralNetwork/Neuron.hpp>
+#include <Toolbox/NeuralNetwork/ProcessingOrder.hpp>
+#include <Toolbox/NeuralNetwork/Profile.hpp>
+#include <Toolbox/NeuralNetwork/Sparse.hpp>
+#include <Toolbox/NeuralNetwork/WorkerPool.hpp>
 
 
 namespace Toolbox
 {
 	namespace NeuralNetwork
 	{
+		// Defaults
 		namespace Default
 		{
-			const size_t MaxProcessingCycles	= 100000;
+			const size_t ParallelWidth			= 1024;
+			const bool Incremental				= false;
+			const bool SoftmaxOutput			= false;
 		}
 
 
@@ -76,6 +202,9 @@ namespace Toolbox
 			typedef std::map< tNeuronIndex, std::map<tNeuronIndex, typename ttNeuron::Ptr> >	tHiddenLayers;
 			typedef std::map< std::string, typename ttLabeledNeuron::Ptr >						tIOLayer;
 			typedef std::list< typename _Neuron<tNeurotransmitter>::Ptr >						tNeuronList;
+			typedef tCompiledGanglion< ttNeuron >												ttCompiledGanglion;
+			typedef tSparseGanglion< ttNeuron >													ttSparseGanglion;
+			typedef tProfiler< tNeurotransmitter >												ttProfiler;
 
 		public:
 			tIOLayer				Input;
@@ -86,17 +215,33 @@ namespace Toolbox
 			typename ttNeuron::Ptr	BiasNeuron;
 			tNeurotransmitter		DefaultThreshold;
 
+			size_t					ParallelWidth;	// Levels with fewer neurons than this are processed on the calling thread, even with a WorkerPool
+			bool					Incremental;	// Only reprocess neurons downstream of inputs that changed since the last pass
+			bool					SoftmaxOutput;	// The outputs are a softmax over their weighted sums (adding up to 1) rather than each being activated on its own
+
+			typename ttProfiler::Ptr	Profiler;		// Hears about every Process() -- Only with TOOLBOX_NEURALNETWORK_PROFILE defined (see Profile.hpp)
+
 		public:
 			tGanglion():
 				UseBias( true ),
-				DefaultThreshold( tNeurotransmitter() )
+				DefaultThreshold( tNeurotransmitter() ),
+				ParallelWidth( Default::ParallelWidth ),
+				Incremental( Default::Incremental ),
+				SoftmaxOutput( Default::SoftmaxOutput ),
+				_Unscheduled( true ),
+				_UpToDate( false )
 			{
 				_CreateBias();
 			}
 
 			tGanglion( bool useThreshold, const tNeurotransmitter &value = tNeurotransmitter(1) ):
 				UseBias( !useThreshold ),
-				DefaultThreshold( value )
+				DefaultThreshold( value ),
+				ParallelWidth( Default::ParallelWidth ),
+				Incremental( Default::Incremental ),
+				SoftmaxOutput( Default::SoftmaxOutput ),
+				_Unscheduled( true ),
+				_UpToDate( false )
 			{
 				_CreateBias();
 			}
@@ -113,7 +258,9 @@ namespace Toolbox
 					++CurLayer;
 
 				for ( size_t i = 0; i < numNeurons; ++i )
-					Hidden[ CurLayer ][ i ] = std::make_shared< ttNeuron >( DefaultThreshold );
+					Hidden[ CurLayer ][ i ] = _newNeuron< ttNeuron >( DefaultThreshold );
+
+				_Unscheduled = true;
 			}
 
 			// By default, we connect as a fully-connected, feed-forward network
@@ -194,57 +341,42 @@ namespace Toolbox
 						}
 					}
 				}
+
+				_schedule();
 			}
 
 			// All input values should be set prior to processing the network -- will stop after maxProcessingCycles or when no more neurons need processing (typically when the network settles and "generates output")
 			virtual void Process( size_t maxProcessingCycles = Default::MaxProcessingCycles )
 			{
-				tNeuronList ProcessingList, NextList;
-
-				// Start by adding the input neurons to our processing list
-				for ( auto i = Input.begin(), i_end = Input.end(); i != i_end; ++i )
-				{
-					auto Input = i->second;
-					Input->NeedsProcessing();
-					ProcessingList.push_back( Input );
-				}
-
-				size_t CurCycle = 0;
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				double ProfileStart = (Profiler ? Profiler->Now() : 0.0);
+#endif
+				_tPassCounters Counters;
 
-				// While we still have anything in it, lets go through our processing list
-				while ( !ProcessingList.empty() )
-				{
-					if ( maxProcessingCycles != 0 && CurCycle++ >= maxProcessingCycles )
-						break;
+				if ( SoftmaxOutput && !UseBias )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::Ganglion::Process(): SoftmaxOutput needs a network using a bias." );
 
-					NextList.clear();
+				if ( _Unscheduled )
+					_schedule();
 
-					for ( auto n = ProcessingList.begin(), n_end = ProcessingList.end(); n != n_end; ++n )
-					{
-						// If neurons fire, add their axons to the next processing list
-						if ( (*n)->Process(!UseBias) )
-						{
-							for ( auto a = (*n)->Axons.begin(), a_end = (*n)->Axons.end(); a != a_end; ++a )
-							{
-								auto Axon = a->lock();
+				if ( Incremental && UseBias && _UpToDate )
+					_processChanges( maxProcessingCycles, Counters );
+				else
+					_processAll( maxProcessingCycles, Counters );
 
-								if ( Axon )
-								{
-									Axon->NeedsProcessing();
-									NextList.push_back( Axon );
-								}
-							}
-						}
-					}
+				if ( SoftmaxOutput )
+					_softmaxOutputs();
 
-					// Copy our processing list to prepare for the next round
-					ProcessingList = NextList;
-				}
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				if ( Profiler )
+					Profiler->AddPass( ProfileStart, { Counters.Neurons, Counters.Cycles, maxProcessingCycles, Counters.Limited } );
+#endif
 			}
 
 			void NewInput( const std::string &label )
 			{
-				Input[ label ] = std::make_shared< ttLabeledNeuron >( label, DefaultThreshold );
+				Input[ label ] = _newNeuron< ttLabeledNeuron >( label, DefaultThreshold );
+				_Unscheduled = true;
 			}
 
 			void SetInput( const std::string &label, tNeurotransmitter value = tNeurotransmitter() )
@@ -254,12 +386,30 @@ namespace Toolbox
 				if ( CurInput == Input.end() )
 					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::Ganglion::SetInput(): Input '") + label + std::string("' not found.") );
 
-				Input[ label ]->SetValue( value );
+				// Setting the same value again leaves the input (and everything it reaches) as it was
+				if ( Incremental && value == CurInput->second->PrevValue() )
+					return;
+
+				CurInput->second->SetValue( value );
+			}
+
+			// The next Process() starts over from scratch -- Needed after changing weights or thresholds with Incremental on
+			void Invalidate()
+			{
+				_UpToDate = false;
+			}
+
+			// The next Process() works out a new schedule -- Needed after connecting or disconnecting neurons by hand
+			void Reschedule()
+			{
+				_Unscheduled = true;
+				_UpToDate = false;
 			}
 
 			void NewOutput( const std::string &label )
 			{
-				Output[ label ] = std::make_shared< ttLabeledNeuron >( label, DefaultThreshold );
+				Output[ label ] = _newNeuron< ttLabeledNeuron >( label, DefaultThreshold );
+				_Unscheduled = true;
 			}
 
 			tNeurotransmitter GetOutput( const std::string &label )
@@ -269,9 +419,36 @@ namespace Toolbox
 				if ( CurOutput == Output.end() )
 					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::Ganglion::GetOutput(): Output '") + label + std::string("' not found.") );
 
+				if ( SoftmaxOutput )
+				{
+					if ( _Softmax.size() != Output.size() )
+						_softmaxOutputs();
+
+					return _Softmax[ std::distance(Output.begin(), CurOutput) ];
+				}
+
 				return CurOutput->second->Value();
 			}
 
+			// All of the output values at once, in label order (the same order as Output)
+			void GetOutputs( std::vector<tNeurotransmitter> &outputs )
+			{
+				if ( SoftmaxOutput )
+				{
+					if ( _Softmax.size() != Output.size() )
+						_softmaxOutputs();
+
+					outputs = _Softmax;
+					return;
+				}
+
+				outputs.resize( Output.size() );
+
+				size_t CurOutput = 0;
+				for ( auto o = Output.begin(), o_end = Output.end(); o != o_end; ++o, ++CurOutput )
+					outputs[ CurOutput ] = o->second->Value();
+			}
+
 			typename ttNeuron::Ptr GetOutputNeuron( const std::string &label )
 			{
 				auto CurOutput = Output.find( label );
@@ -282,17 +459,670 @@ namespace Toolbox
 				return CurOutput->second;
 			}
 
+			// Processes many records at once -- 'inputs' is row-major with one column per Input (in label order), and 'outputs' receives one row per record with one column per Output (in label order)
+			// NOTE: This works on a freshly compiled copy of the network and leaves the neurons untouched -- Keep a Compile()d copy around to avoid recompiling for each batch
+			// NOTE: Recurrent networks can't be batched (their memory would be left out) -- Use tRecurrent<>::ProcessSequence() instead
+			void ProcessBatch( const std::vector<tNeurotransmitter> &inputs, std::vector<tNeurotransmitter> &outputs, size_t maxProcessingCycles = Default::MaxProcessingCycles ) const
+			{
+				if ( tHasMemory<ttNeuron>::value )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::Ganglion::ProcessBatch(): Recurrent networks can't be batched -- Use tRecurrent<>::ProcessSequence() instead." );
+
+				ttCompiledGanglion Compiled( *this );
+				Compiled.ProcessBatch( inputs, outputs, maxProcessingCycles );
+			}
+
+			// Flattens the (connected) network into dense per-layer matrices -- See <Toolbox/NeuralNetwork/Compiled.hpp>
+			ttCompiledGanglion Compile() const
+			{
+				return ttCompiledGanglion( *this );
+			}
+
+			// Flattens any non-recurrent network (layered or not) into compressed sparse rows -- See <Toolbox/NeuralNetwork/Sparse.hpp>
+			ttSparseGanglion CompileSparse() const
+			{
+				return ttSparseGanglion( *this );
+			}
+
+			// Allocates our neurons (and their connections) from an arena from now on -- Must be called before any neurons are added
+			void UseArena( const Arena::Ptr &arena = std::make_shared<Arena>() )
+			{
+				if ( !Input.empty() || !Output.empty() || !Hidden.empty() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::Ganglion::UseArena(): Network already has neurons." );
+
+				_Arena = arena;
+				_CreateBias();
+			}
+
+			// NULL when allocating from the heap
+			Arena::Ptr GetArena() const
+			{
+				return _Arena;
+			}
+
+			// Spreads each level of Process() across the pool from now on (see the notes above) -- NULL goes back to processing on the calling thread
+			void UseWorkerPool( const WorkerPool::Ptr &pool = std::make_shared<WorkerPool>() )
+			{
+				_WorkerPool = pool;
+			}
+
+			WorkerPool::Ptr GetWorkerPool() const
+			{
+				return _WorkerPool;
+			}
+
+			// Writes the whole network out to a file -- See <Toolbox/NeuralNetwork/NetworkFile.hpp>
+			void Save( const std::string &fileName ) const
+			{
+				NetworkFile::tHeader Header;
+				tNumberedNeurons Neurons;
+				std::vector< tNeurotransmitter * > Weights;
+
+				if ( !_describe(Header, Neurons, Weights) )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::Ganglion::Save(): Network is connected to neurons outside of itself." );
+
+				std::ofstream File( fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+
+				if ( !File )
+					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::Ganglion::Save(): Unable to create '") + fileName + std::string("'.") );
+
+				NetworkFile::WriteHeader( File, Header );
+
+				for ( uint64_t Pad = uint64_t(File.tellp()); Pad < Header.DataOffset; ++Pad )
+					File.put( 0 );
+
+				std::vector< tNeurotransmitter > Values;
+				Values.reserve( 2 + Neurons.size() + Weights.size() );
+
+				Values.push_back( DefaultThreshold );
+				Values.push_back( BiasNeuron->Value() );
+
+				for ( auto n = Neurons.begin(), n_end = Neurons.end(); n != n_end; ++n )
+					Values.push_back( (*n)->Threshold );
+
+				for ( auto w = Weights.begin(), w_end = Weights.end(); w != w_end; ++w )
+					Values.push_back( **w );
+
+				TrainingFile::WriteValues( File, Values.data(), Values.size() );
+
+				if ( !File )
+					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::Ganglion::Save(): Unable to write '") + fileName + std::string("'.") );
+			}
+
+			// Reads a network written by Save(), replacing this one -- Only the values are copied if we're already put together the same way
+			void Load( const std::string &fileName )
+			{
+				MappedFile File( fileName );
+				NetworkFile::tHeader Header;
+				NetworkFile::ReadHeader( File.Data(), File.Size(), Header );
+
+				NetworkFile::tHeader Current;
+				tNumberedNeurons Neurons;
+				std::vector< tNeurotransmitter * > Weights;
+
+				// Put back if the file turns out to be bad, so we're left as we were
+				const bool OldSoftmaxOutput = SoftmaxOutput;
+
+				SoftmaxOutput = ((Header.Flags & NetworkFile::SoftmaxOutput) != 0);
+
+				if ( !_describe(Current, Neurons, Weights) || !Header.SameTopology(Current) )
+				{
+					// Our own neurons stay connected to each other as long as something holds on to them
+					tIOLayer OldInput = Input;
+					tIOLayer OldOutput = Output;
+					tHiddenLayers OldHidden = Hidden;
+					typename ttNeuron::Ptr OldBiasNeuron = BiasNeuron;
+					const bool OldUseBias = UseBias;
+
+					try
+					{
+						_build( Header );
+
+						// Anything that doesn't come out the same (repeated labels or connections, for example) would put the weights in the wrong places
+						if ( !_describe(Current, Neurons, Weights) || !Header.SameTopology(Current) )
+							throw std::runtime_error( std::string("Toolbox::NeuralNetwork::Ganglion::Load(): '") + fileName + std::string("' is corrupt.") );
+					}
+					catch ( ... )
+					{
+						Input.swap( OldInput );
+						Output.swap( OldOutput );
+						Hidden.swap( OldHidden );
+						BiasNeuron = OldBiasNeuron;
+						UseBias = OldUseBias;
+						SoftmaxOutput = OldSoftmaxOutput;
+						_Unscheduled = true;
+						throw;
+					}
+				}
+
+				const unsigned char *Data = File.Data();
+				const size_t ValueSize = TrainingFile::ValueSize( Header.ValueType );
+
+				DefaultThreshold = TrainingFile::ReadValue< tNeurotransmitter >( Data + Header.DataOffset, Header.ValueType );
+				BiasNeuron->SetValue( TrainingFile::ReadValue< tNeurotransmitter >(Data + Header.DataOffset + ValueSize, Header.ValueType) );
+
+				const unsigned char *Threshold = Data + Header.ThresholdOffset();
+
+				for ( auto n = Neurons.begin(), n_end = Neurons.end(); n != n_end; ++n, Threshold += ValueSize )
+					(*n)->Threshold = TrainingFile::ReadValue< tNeurotransmitter >( Threshold, Header.ValueType );
+
+				const unsigned char *Weight = Data + Header.WeightOffset();
+
+				for ( auto w = Weights.begin(), w_end = Weights.end(); w != w_end; ++w, Weight += ValueSize )
+					**w = TrainingFile::ReadValue< tNeurotransmitter >( Weight, Header.ValueType );
+
+				Invalidate();
+			}
+
 		protected:
+			typedef std::vector< typename _Neuron<tNeurotransmitter>::Ptr >						tNumberedNeurons;
+
+			// What a pass did, for the profiler -- Shared by every thread processing the pass (and empty without profiling)
+			struct _tPassCounters
+			{
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				std::atomic< size_t >	Neurons{ 0 };
+				std::atomic< size_t >	Cycles{ 0 };		// The latest processing cycle anything was processed in
+				std::atomic< bool >		Limited{ false };	// maxProcessingCycles left something unprocessed
+#endif
+			};
+
+		protected:
+			Arena::Ptr				_Arena;			// Where new neurons come from -- NULL for the heap
+			WorkerPool::Ptr			_WorkerPool;	// NULL processes on the calling thread
+
+			// The processing schedule -- Every neuron reachable from the inputs, in processing order (positions in _Order.Order)
+			ProcessingOrder								_Order;
+			std::vector< _Neuron<tNeurotransmitter> * >	_Scheduled;
+			std::vector< size_t >						_ScheduledInputs;	// Into _Scheduled, in the same order as Input
+			std::vector< size_t >						_FirstAxon;			// Per scheduled neuron, plus one past the end -- Index into _Axon (only axons within the neuron's own group)
+			std::vector< size_t >						_Axon;				// Into _Scheduled
+			std::vector< size_t >						_FirstSource;		// Per scheduled neuron, plus one past the end -- Index into _Source (only dendrites from earlier groups)
+			std::vector< size_t >						_Source;			// Into _Scheduled
+			std::vector< unsigned char >				_Pending;			// Per scheduled neuron -- Whether it needs processing during this pass
+			std::vector< unsigned char >				_Fired;				// Per scheduled neuron -- Whether it has fired during this pass
+			bool										_Unscheduled;		// The network has changed shape since _schedule() last ran
+
+			// For incremental passes
+			bool										_UpToDate;			// Every scheduled neuron's value is current (a full pass has been through since anything else changed)
+			std::vector< size_t >						_GroupOf;			// Per scheduled neuron -- Into _Order.Groups
+			std::vector< size_t >						_FirstLaterAxon;	// Per scheduled neuron, plus one past the end -- Index into _LaterAxon
+			std::vector< size_t >						_LaterAxon;			// Into _Scheduled -- The axons _Axon leaves out (into later groups)
+			std::vector< size_t >						_LoopStarts;		// Into _Scheduled -- Neurons in recurrent groups with an input from outside the group
+			std::vector< std::vector<size_t> >			_Changed;			// Per level -- Groups with something to reprocess, into _Order.Groups
+			std::vector< unsigned char >				_GroupChanged;		// Per group -- Whether it's in _Changed
+
+			std::vector< tNeurotransmitter >			_Softmax;			// Per output (in label order) -- The softmax outputs from the last pass
+
+		protected:
+			// Numbers our neurons and dendrites the way NetworkFile does -- Returns false if any dendrite reaches outside of the network
+			bool _describe( NetworkFile::tHeader &header, tNumberedNeurons &neurons, std::vector<tNeurotransmitter *> &weights ) const
+			{
+				header = NetworkFile::tHeader();
+				header.Version = NetworkFile::Version;
+				header.ValueType = TrainingFile::ValueType< tNeurotransmitter >();
+				header.Flags = (UseBias ? NetworkFile::UseBias : 0) | (SoftmaxOutput ? NetworkFile::SoftmaxOutput : 0);
+
+				neurons.clear();
+				weights.clear();
+				neurons.push_back( BiasNeuron );
+
+				for ( auto i = Input.begin(), i_end = Input.end(); i != i_end; ++i )
+				{
+					header.InputLabels.push_back( i->first );
+					neurons.push_back( i->second );
+				}
+
+				for ( auto l = Hidden.begin(), l_end = Hidden.end(); l != l_end; ++l )
+				{
+					NetworkFile::tHiddenLayer CurLayer;
+					CurLayer.Index = l->first;
+
+					for ( auto h = l->second.begin(), h_end = l->second.end(); h != h_end; ++h )
+					{
+						CurLayer.Neurons.push_back( h->first );
+						neurons.push_back( h->second );
+					}
+
+					header.HiddenLayers.push_back( CurLayer );
+				}
+
+				for ( auto o = Output.begin(), o_end = Output.end(); o != o_end; ++o )
+				{
+					header.OutputLabels.push_back( o->first );
+					neurons.push_back( o->second );
+				}
+
+				std::map< const _Neuron<tNeurotransmitter> *, uint32_t > Numbers;
+
+				for ( size_t n = 0, n_end = neurons.size(); n < n_end; ++n )
+					Numbers[ neurons[n].get() ] = uint32_t( n );
+
+				bool Complete = true;
+				std::vector< std::pair<uint32_t, tNeurotransmitter *> > Dendrites;
+
+				header.FirstDendrite.push_back( 0 );
+
+				for ( auto n = neurons.begin(), n_end = neurons.end(); n != n_end; ++n )
+				{
+					Dendrites.clear();
+
+					for ( auto d = (*n)->Dendrites.begin(), d_end = (*n)->Dendrites.end(); d != d_end; ++d )
+					{
+						auto Dendrite = (d->first).lock();
+
+						if ( !Dendrite )
+							continue;
+
+						auto Number = Numbers.find( Dendrite.get() );
+
+						if ( Number == Numbers.end() )
+						{
+							Complete = false;
+							continue;
+						}
+
+						Dendrites.push_back( std::make_pair(Number->second, &d->second) );
+					}
+
+					std::sort( Dendrites.begin(), Dendrites.end() );
+
+					for ( auto d = Dendrites.begin(), d_end = Dendrites.end(); d != d_end; ++d )
+					{
+						header.Source.push_back( d->first );
+						weights.push_back( d->second );
+					}
+
+					header.FirstDendrite.push_back( header.Source.size() );
+				}
+
+				header.DataOffset = NetworkFile::DataOffset( header );
+
+				return Complete;
+			}
+
+			// Works out the order to process our neurons in (see ProcessingOrder.hpp)
+			void _schedule()
+			{
+				typedef _Neuron< tNeurotransmitter >	tBaseNeuron;
+
+				_Unscheduled = false;
+
+				// Number every neuron the inputs can reach (the inputs first)
+				std::vector< tBaseNeuron * > Found;
+				std::map< const tBaseNeuron *, size_t > Numbers;
+				std::vector< size_t > Inputs, FirstAxon( 1, 0 ), Axon;
+
+				auto Number = [&Found, &Numbers]( tBaseNeuron *neuron ) -> size_t
+					{
+						auto n = Numbers.find( neuron );
+
+						if ( n != Numbers.end() )
+							return n->second;
+
+						Numbers[ neuron ] = Found.size();
+						Found.push_back( neuron );
+						return Found.size() - 1;
+					};
+
+				for ( auto i = Input.begin(), i_end = Input.end(); i != i_end; ++i )
+					Inputs.push_back( Number(i->second.get()) );
+
+				for ( size_t n = 0; n < Found.size(); ++n )
+				{
+					for ( auto a = Found[n]->Axons.begin(), a_end = Found[n]->Axons.end(); a != a_end; ++a )
+					{
+						auto CurAxon = a->lock();
+
+						if ( CurAxon )
+							Axon.push_back( Number(CurAxon.get()) );
+					}
+
+					FirstAxon.push_back( Axon.size() );
+				}
+
+				_Order.Build( FirstAxon, Axon, Inputs );
+
+				// Then lay everything out in processing order -- Axons within a group are followed as the group is processed, and everything else is picked up from the other end once its group's turn comes
+				size_t NumScheduled = _Order.Order.size();
+				std::vector< size_t > NumSources( NumScheduled, 0 );
+				_GroupOf.assign( NumScheduled, 0 );
+
+				for ( size_t g = 0, g_end = _Order.Groups.size(); g < g_end; ++g )
+					std::fill( _GroupOf.begin() + _Order.Groups[g].First, _GroupOf.begin() + _Order.Groups[g].Last, g );
+
+				_Scheduled.clear();
+				_ScheduledInputs.clear();
+				_FirstAxon.assign( 1, 0 );
+				_Axon.clear();
+				_FirstLaterAxon.assign( 1, 0 );
+				_LaterAxon.clear();
+				_LoopStarts.clear();
+				_Pending.assign( NumScheduled, 0 );
+				_Fired.assign( NumScheduled, 0 );
+				_Changed.assign( _Order.Levels.size() - 1, std::vector<size_t>() );
+				_GroupChanged.assign( _Order.Groups.size(), 0 );
+				_UpToDate = false;
+
+				for ( auto i = Inputs.begin(), i_end = Inputs.end(); i != i_end; ++i )
+					_ScheduledInputs.push_back( _Order.Position[*i] );
+
+				for ( size_t p = 0; p < NumScheduled; ++p )
+				{
+					size_t n = _Order.Order[ p ];
+					_Scheduled.push_back( Found[n] );
+
+					for ( size_t a = FirstAxon[n], a_end = FirstAxon[n + 1]; a < a_end; ++a )
+					{
+						size_t CurAxon = _Order.Position[ Axon[a] ];
+
+						if ( _GroupOf[CurAxon] == _GroupOf[p] )
+							_Axon.push_back( CurAxon );
+						else
+						{
+							_LaterAxon.push_back( CurAxon );
+							++NumSources[ CurAxon ];
+						}
+					}
+
+					_FirstAxon.push_back( _Axon.size() );
+					_FirstLaterAxon.push_back( _LaterAxon.size() );
+				}
+
+				_FirstSource.assign( 1, 0 );
+
+				for ( size_t p = 0; p < NumScheduled; ++p )
+					_FirstSource.push_back( _FirstSource.back() + NumSources[p] );
+
+				std::vector< size_t > NextSource( _FirstSource.begin(), _FirstSource.end() - 1 );
+				_Source.assign( _FirstSource.back(), 0 );
+
+				for ( size_t p = 0; p < NumScheduled; ++p )
+				{
+					size_t n = _Order.Order[ p ];
+
+					for ( size_t a = FirstAxon[n], a_end = FirstAxon[n + 1]; a < a_end; ++a )
+					{
+						size_t CurAxon = _Order.Position[ Axon[a] ];
+
+						if ( _GroupOf[CurAxon] != _GroupOf[p] )
+							_Source[ NextSource[CurAxon]++ ] = p;
+					}
+				}
+
+				// Recurrent groups (including a neuron feeding itself) never settle the same way twice, so incremental passes go around them every time
+				for ( size_t g = 0, g_end = _Order.Groups.size(); g < g_end; ++g )
+				{
+					const ProcessingOrder::tGroup &CurGroup = _Order.Groups[ g ];
+
+					if ( CurGroup.Last - CurGroup.First == 1 && _FirstAxon[CurGroup.First] == _FirstAxon[CurGroup.Last] )
+						continue;
+
+					for ( size_t n = CurGroup.First; n < CurGroup.Last; ++n )
+					{
+						if ( _FirstSource[n] != _FirstSource[n + 1] )
+							_LoopStarts.push_back( n );
+					}
+				}
+			}
+
+			// A full pass, starting from every input
+			void _processAll( size_t maxProcessingCycles, _tPassCounters &counters )
+			{
+				std::fill( _Pending.begin(), _Pending.end(), 0 );
+				std::fill( _Fired.begin(), _Fired.end(), 0 );
+
+				// Start with the input neurons
+				for ( auto i = _ScheduledInputs.begin(), i_end = _ScheduledInputs.end(); i != i_end; ++i )
+					_Pending[ *i ] = 1;
+
+				// Nothing in a level feeds into anything else in it, so each level's groups can be processed in any order (or all at once)
+				for ( size_t l = 0, l_end = _Order.Levels.size() - 1; l < l_end; ++l )
+				{
+					size_t FirstGroup = _Order.Levels[ l ];
+					size_t NumGroups = _Order.Levels[ l + 1 ] - FirstGroup;
+
+					if ( NumGroups == 0 )
+						continue;
+
+					size_t Width = _Order.Groups[ FirstGroup + NumGroups - 1 ].Last - _Order.Groups[ FirstGroup ].First;
+
+					if ( !_WorkerPool || NumGroups < 2 || Width < ParallelWidth )
+					{
+						for ( size_t g = FirstGroup; g < FirstGroup + NumGroups; ++g )
+							_processGroup( _Order.Groups[g], maxProcessingCycles, counters );
+
+						continue;
+					}
+
+					// Split the level into one contiguous run of groups per thread -- Run() returns once they've all finished
+					size_t NumTasks = std::min( NumGroups, _WorkerPool->NumThreads() );
+
+					_WorkerPool->Run( NumTasks, [this, FirstGroup, NumGroups, NumTasks, maxProcessingCycles, &counters]( size_t task )
+						{
+							for ( size_t g = FirstGroup + (NumGroups * task / NumTasks), g_end = FirstGroup + (NumGroups * (task + 1) / NumTasks); g < g_end; ++g )
+								_processGroup( _Order.Groups[g], maxProcessingCycles, counters );
+						} );
+				}
+
+				_UpToDate = true;
+			}
+
+			// An incremental pass -- Only the inputs set to something new since the last pass, and whatever their changes reach
+			void _processChanges( size_t maxProcessingCycles, _tPassCounters &counters )
+			{
+				// SetValue() is the only thing that leaves an input unprocessed between passes
+				for ( auto i = _ScheduledInputs.begin(), i_end = _ScheduledInputs.end(); i != i_end; ++i )
+				{
+					if ( !_Scheduled[*i]->Processed() )
+						_touch( *i );
+				}
+
+				for ( auto n = _LoopStarts.begin(), n_end = _LoopStarts.end(); n != n_end; ++n )
+					_touch( *n );
+
+				// Changes only ever flow into later levels, so each level's list is complete by the time we get to it
+				for ( size_t l = 0, l_end = _Changed.size(); l < l_end; ++l )
+				{
+					std::vector< size_t > &Groups = _Changed[ l ];
+
+					for ( size_t g = 0; g < Groups.size(); ++g )
+					{
+						const ProcessingOrder::tGroup &CurGroup = _Order.Groups[ Groups[g] ];
+
+						_processGroup( CurGroup, maxProcessingCycles, counters, true );
+
+						// Anything maxProcessingCycles kept us from getting to waits for the next full pass, the same as it would have
+						std::fill( _Pending.begin() + CurGroup.First, _Pending.begin() + CurGroup.Last, 0 );
+						_GroupChanged[ Groups[g] ] = 0;
+					}
+
+					Groups.clear();
+				}
+			}
+
+			// The neurons only keep their activated values, so each output's weighted sum is gathered again, then the whole layer goes through the softmax at once
+			void _softmaxOutputs()
+			{
+				_Softmax.resize( Output.size() );
+
+				size_t CurOutput = 0;
+				for ( auto o = Output.begin(), o_end = Output.end(); o != o_end; ++o, ++CurOutput )
+					_Softmax[ CurOutput ] = ttNeuron::Accumulate( o->second );
+
+				Activation::Softmax( _Softmax.data(), _Softmax.data(), _Softmax.size() );
+			}
+
+			// Queues a neuron (and its group) for an incremental pass
+			void _touch( size_t n )
+			{
+				if ( !_Pending[n] )
+				{
+					_Pending[ n ] = 1;
+					_Scheduled[ n ]->NeedsProcessing();
+				}
+
+				size_t Group = _GroupOf[ n ];
+
+				if ( !_GroupChanged[Group] )
+				{
+					_GroupChanged[ Group ] = 1;
+					_Changed[ _Order.Groups[Group].Level ].push_back( Group );
+				}
+			}
+
+			// Processes one group from the schedule -- Only touches the group's own neurons, so groups within a level can be processed side by side (apart from incremental passes, which pass changes on to later groups themselves)
+			void _processGroup( const ProcessingOrder::tGroup &group, size_t maxProcessingCycles, _tPassCounters &counters, bool incremental = false )
+			{
+				// Anything that fired into the group (from earlier levels) means processing
+				for ( size_t n = group.First; n < group.Last && !incremental; ++n )
+				{
+					for ( size_t s = _FirstSource[n], s_end = _FirstSource[n + 1]; s < s_end && !_Pending[n]; ++s )
+						_Pending[ n ] = _Fired[ _Source[s] ];
+
+					if ( _Pending[n] )
+						_Scheduled[ n ]->NeedsProcessing();
+				}
+
+				size_t CurCycle = group.Level;
+				bool Again = false;
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				size_t Processed = 0, Iterations = 0, UsedCycle = 0;
+#endif
+
+				// Recurrent groups go around again whenever a neuron fires back into one we've already been through
+				do
+				{
+					if ( maxProcessingCycles != 0 && CurCycle++ >= maxProcessingCycles )
+					{
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						for ( size_t n = group.First; n < group.Last; ++n )
+						{
+							if ( _Pending[n] )
+								counters.Limited = true;
+						}
+#endif
+						break;
+					}
+
+					Again = false;
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+					++Iterations;
+#endif
+
+					for ( size_t n = group.First; n < group.Last; ++n )
+					{
+						if ( !_Pending[n] )
+							continue;
+
+						_Pending[ n ] = 0;
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						++Processed;
+						UsedCycle = group.Level + Iterations;
+#endif
+
+						// If neurons fire, their axons need processing
+						if ( _Scheduled[n]->Process(!UseBias) )
+						{
+							_Fired[ n ] = 1;
+
+							for ( size_t a = _FirstAxon[n], a_end = _FirstAxon[n + 1]; a < a_end; ++a )
+							{
+								_Scheduled[ _Axon[a] ]->NeedsProcessing();
+								_Pending[ _Axon[a] ] = 1;
+
+								if ( _Axon[a] <= n )
+									Again = true;
+							}
+
+							// Later groups only need to hear about it if our value actually moved (inputs were only queued because theirs did)
+							if ( incremental && (_Scheduled[n]->Dendrites.empty() || _Scheduled[n]->Value() != _Scheduled[n]->PrevValue()) )
+							{
+								for ( size_t a = _FirstLaterAxon[n], a_end = _FirstLaterAxon[n + 1]; a < a_end; ++a )
+									_touch( _LaterAxon[a] );
+							}
+						}
+					}
+				}
+				while ( Again );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				counters.Neurons += Processed;
+
+				for ( size_t Prev = counters.Cycles; Prev < UsedCycle && !counters.Cycles.compare_exchange_weak(Prev, UsedCycle); )
+					;
+#else
+				(void)counters;
+#endif
+			}
+
+			// Throws away every neuron we have and connects up new ones to match the file (with zero weights)
+			void _build( const NetworkFile::tHeader &header )
+			{
+				Input.clear();
+				Output.clear();
+				Hidden.clear();
+
+				UseBias = ((header.Flags & NetworkFile::UseBias) != 0);
+				_CreateBias();
+
+				tNumberedNeurons Neurons;
+				Neurons.push_back( BiasNeuron );
+
+				for ( auto i = header.InputLabels.begin(), i_end = header.InputLabels.end(); i != i_end; ++i )
+				{
+					NewInput( *i );
+					Neurons.push_back( Input[*i] );
+				}
+
+				for ( auto l = header.HiddenLayers.begin(), l_end = header.HiddenLayers.end(); l != l_end; ++l )
+				{
+					auto &CurLayer = Hidden[ tNeuronIndex(l->Index) ];
+
+					for ( auto n = l->Neurons.begin(), n_end = l->Neurons.end(); n != n_end; ++n )
+					{
+						auto &CurNeuron = CurLayer[ tNeuronIndex(*n) ];
+						CurNeuron = _newNeuron< ttNeuron >( DefaultThreshold );
+						Neurons.push_back( CurNeuron );
+					}
+				}
+
+				for ( auto o = header.OutputLabels.begin(), o_end = header.OutputLabels.end(); o != o_end; ++o )
+				{
+					NewOutput( *o );
+					Neurons.push_back( Output[*o] );
+				}
+
+				for ( size_t n = 0, n_end = Neurons.size(); n < n_end; ++n )
+				{
+					for ( uint64_t d = header.FirstDendrite[n], d_end = header.FirstDendrite[n + 1]; d < d_end; ++d )
+						Neurons[ n ]->AddDendrite( Neurons[header.Source[d]], tNeurotransmitter() );
+				}
+			}
+
 			void _CreateBias()
 			{
-				BiasNeuron = std::make_shared< ttNeuron >();
+				BiasNeuron = _newNeuron< ttNeuron >( tNeurotransmitter() );
 				BiasNeuron->SetValue( tNeurotransmitter(1) );
+				_Unscheduled = true;
+			}
+
+			template <typename tType, typename... tArgs>
+			typename tType::Ptr _newNeuron( tArgs&&... args ) const
+			{
+				if ( !_Arena )
+					return std::make_shared< tType >( std::forward<tArgs>(args)... );
+
+				return std::allocate_shared< tType >( tArenaAllocator<tType>(_Arena), std::forward<tArgs>(args)..., _Arena->Resource() );
 			}
 		};
 
 
 		// Then define our default Ganglion type
-		typedef tGanglion<>	Ganglion;
+		typedef tGanglion<>					Ganglion;
+		typedef tGanglion< FloatNeuron >	FloatGanglion;
 	}
 }
 
@@ -0,0 +1,128 @@
+#ifndef TOOLBOX_NEURALNETWORK_MAPPEDFILE_HPP
+#define TOOLBOX_NEURALNETWORK_MAPPEDFILE_HPP
+
+/*
+ * Toolbox/NeuralNetwork/MappedFile.hpp
+ *
+ * A read-only, memory-mapped file.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - The whole file is mapped (read-only, shared) when the object is created
+ *   and unmapped when it is destroyed.  Nothing is actually read until it is
+ *   touched, so opening even a very large file is instant, and the pages are
+ *   shared (through the OS page cache) with every other process mapping the
+ *   same file.
+ *
+ * - The mapping starts on a page boundary, so anything in the file that is
+ *   aligned (relative to the start of the file) stays aligned in memory.
+ *
+ * - POSIX only (mmap()).
+ *
+ ****************************************************************************
+	Toolbox::NeuralNetwork::MappedFile File( "training.dat" );
+
+	const unsigned char *Data = File.Data();
+	size_t Size = File.Size();
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <stdexcept>
+#include <string>
+
+#include <Toolbox/Defines.h>
+
+
+extern "C"
+{
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		class MappedFile
+		{
+		public:
+			TOOLBOX_POINTERS( MappedFile )
+
+		public:
+			MappedFile( const std::string &fileName ):
+				_Data( NULL ),
+				_Size( 0 )
+			{
+				int File = open( fileName.c_str(), O_RDONLY );
+
+				if ( File < 0 )
+					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::MappedFile::MappedFile(): Unable to open '") + fileName + std::string("'.") );
+
+				struct stat FileInfo;
+
+				if ( fstat(File, &FileInfo) != 0 )
+				{
+					close( File );
+					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::MappedFile::MappedFile(): Unable to read the size of '") + fileName + std::string("'.") );
+				}
+
+				_Size = size_t( FileInfo.st_size );
+
+				// Mapping an empty file fails, but there's nothing to map anyway
+				if ( _Size > 0 )
+				{
+					void *Data = mmap( NULL, _Size, PROT_READ, MAP_SHARED, File, 0 );
+
+					if ( Data == MAP_FAILED )
+					{
+						close( File );
+						throw std::runtime_error( std::string("Toolbox::NeuralNetwork::MappedFile::MappedFile(): Unable to map '") + fileName + std::string("'.") );
+					}
+
+					_Data = static_cast< const unsigned char * >( Data );
+				}
+
+				// The mapping stays valid without the descriptor
+				close( File );
+			}
+
+			MappedFile( const MappedFile & ) = delete;
+			MappedFile &operator=( const MappedFile & ) = delete;
+
+			virtual ~MappedFile()
+			{
+				if ( _Data )
+					munmap( const_cast<unsigned char *>(_Data), _Size );
+			}
+
+			const unsigned char *Data() const
+			{
+				return _Data;
+			}
+
+			size_t Size() const
+			{
+				return _Size;
+			}
+
+		protected:
+			const unsigned char *	_Data;
+			size_t					_Size;
+		};
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_MAPPEDFILE_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
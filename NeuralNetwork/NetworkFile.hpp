@@ -0,0 +1,305 @@
+#ifndef TOOLBOX_NEURALNETWORK_NETWORKFILE_HPP
+#define TOOLBOX_NEURALNETWORK_NETWORKFILE_HPP
+
+/*
+ * Toolbox/NeuralNetwork/NetworkFile.hpp
+ *
+ * A compact binary file format for ganglia (topology, thresholds and
+ * weights).
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - Everything in the file is little-endian.  The layout is:
+ *
+ *     Offset  Size  Contents
+ *     0       8     "TBNNGANG"
+ *     8       4     Format version (currently 1)
+ *     12      4     Value type (1 = 32-bit float, 2 = 64-bit double)
+ *     16      4     Flags (bit 0 = UseBias, bit 1 = SoftmaxOutput)
+ *     20      4     Number of inputs
+ *     24      4     Number of outputs
+ *     28      4     Number of hidden layers
+ *     32      8     Number of connections (dendrites)
+ *     40      8     Offset of the data (always a multiple of 64)
+ *     48      ...   The topology:
+ *                     Input labels, then output labels -- Each is a 4-byte
+ *                       length followed by that many characters
+ *                     Each hidden layer -- An 8-byte layer index, a 4-byte
+ *                       neuron count, then an 8-byte index for each neuron
+ *                     Each neuron's dendrites -- A 4-byte count, then the
+ *                       4-byte number of the neuron on the other end of each
+ *
+ *   The data is DefaultThreshold, the BiasNeuron's value, each neuron's
+ *   threshold, and finally each dendrite's weight, in the same order as the
+ *   topology.
+ *
+ * - Neurons are numbered in a fixed order: the BiasNeuron (0), the inputs (in
+ *   label order), each hidden layer (in index order), then the outputs (in
+ *   label order).  Each neuron's dendrites are stored sorted by the number of
+ *   the neuron on the other end, so the same network always saves to the
+ *   same file.
+ *
+ * - See tGanglion<>::Save() and Load(), and tCompiledGanglion<>::Load().
+ *
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <Toolbox/NeuralNetwork/TrainingFile.hpp>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		namespace NetworkFile
+		{
+			const char			Magic[ 8 ]		= { 'T', 'B', 'N', 'N', 'G', 'A', 'N', 'G' };
+			const uint32_t		Version			= 1;
+			const size_t		HeaderSize		= 48;	// Everything before the topology
+
+			enum tFlags
+			{
+				UseBias			= 0x01,
+				SoftmaxOutput	= 0x02
+			};
+
+			struct tHiddenLayer
+			{
+				uint64_t					Index;
+				std::vector< uint64_t >		Neurons;		// The index of each neuron within the layer
+
+				bool operator==( const tHiddenLayer &rhs ) const
+				{
+					return Index == rhs.Index && Neurons == rhs.Neurons;
+				}
+			};
+
+			struct tHeader
+			{
+				uint32_t						Version;
+				uint32_t						ValueType;
+				uint32_t						Flags;
+				std::vector< std::string >		InputLabels;
+				std::vector< std::string >		OutputLabels;
+				std::vector< tHiddenLayer >		HiddenLayers;
+				std::vector< uint64_t >			FirstDendrite;	// Per neuron, plus one past the end -- Index into Source
+				std::vector< uint32_t >			Source;			// Per dendrite -- The number of the neuron on the other end
+				uint64_t						DataOffset;
+
+				size_t NumNeurons() const
+				{
+					return FirstDendrite.empty() ? 0 : FirstDendrite.size() - 1;
+				}
+
+				size_t NumConnections() const
+				{
+					return Source.size();
+				}
+
+				// Whether two networks are put together the same way (ignoring the values stored in them)
+				bool SameTopology( const tHeader &rhs ) const
+				{
+					return Flags == rhs.Flags && InputLabels == rhs.InputLabels && OutputLabels == rhs.OutputLabels && HiddenLayers == rhs.HiddenLayers && FirstDendrite == rhs.FirstDendrite && Source == rhs.Source;
+				}
+
+				// Where each part of the data starts
+				uint64_t ThresholdOffset() const
+				{
+					return DataOffset + (2 * TrainingFile::ValueSize(ValueType));
+				}
+
+				uint64_t WeightOffset() const
+				{
+					return ThresholdOffset() + (NumNeurons() * TrainingFile::ValueSize(ValueType));
+				}
+
+				// Where the file should end
+				uint64_t EndOffset() const
+				{
+					return WeightOffset() + (NumConnections() * TrainingFile::ValueSize(ValueType));
+				}
+			};
+
+			inline void WriteHeader( std::ostream &stream, const tHeader &header )
+			{
+				stream.write( Magic, sizeof(Magic) );
+				TrainingFile::Write( stream, header.Version, 4 );
+				TrainingFile::Write( stream, header.ValueType, 4 );
+				TrainingFile::Write( stream, header.Flags, 4 );
+				TrainingFile::Write( stream, header.InputLabels.size(), 4 );
+				TrainingFile::Write( stream, header.OutputLabels.size(), 4 );
+				TrainingFile::Write( stream, header.HiddenLayers.size(), 4 );
+				TrainingFile::Write( stream, header.NumConnections(), 8 );
+				TrainingFile::Write( stream, header.DataOffset, 8 );
+
+				for ( auto i = header.InputLabels.begin(), i_end = header.InputLabels.end(); i != i_end; ++i )
+				{
+					TrainingFile::Write( stream, i->size(), 4 );
+					stream.write( i->data(), std::streamsize(i->size()) );
+				}
+
+				for ( auto o = header.OutputLabels.begin(), o_end = header.OutputLabels.end(); o != o_end; ++o )
+				{
+					TrainingFile::Write( stream, o->size(), 4 );
+					stream.write( o->data(), std::streamsize(o->size()) );
+				}
+
+				for ( auto l = header.HiddenLayers.begin(), l_end = header.HiddenLayers.end(); l != l_end; ++l )
+				{
+					TrainingFile::Write( stream, l->Index, 8 );
+					TrainingFile::Write( stream, l->Neurons.size(), 4 );
+
+					for ( auto n = l->Neurons.begin(), n_end = l->Neurons.end(); n != n_end; ++n )
+						TrainingFile::Write( stream, *n, 8 );
+				}
+
+				for ( size_t n = 0, n_end = header.NumNeurons(); n < n_end; ++n )
+				{
+					TrainingFile::Write( stream, header.FirstDendrite[n + 1] - header.FirstDendrite[n], 4 );
+
+					for ( uint64_t d = header.FirstDendrite[n], d_end = header.FirstDendrite[n + 1]; d < d_end; ++d )
+						TrainingFile::Write( stream, header.Source[d], 4 );
+				}
+			}
+
+			// How much room a header takes up, including the padding before the data
+			inline uint64_t DataOffset( const tHeader &header )
+			{
+				uint64_t Size = HeaderSize;
+
+				for ( auto i = header.InputLabels.begin(), i_end = header.InputLabels.end(); i != i_end; ++i )
+					Size += 4 + i->size();
+
+				for ( auto o = header.OutputLabels.begin(), o_end = header.OutputLabels.end(); o != o_end; ++o )
+					Size += 4 + o->size();
+
+				for ( auto l = header.HiddenLayers.begin(), l_end = header.HiddenLayers.end(); l != l_end; ++l )
+					Size += 12 + (8 * l->Neurons.size());
+
+				Size += (4 * header.NumNeurons()) + (4 * header.NumConnections());
+
+				return ((Size + TrainingFile::DataAlignment - 1) / TrainingFile::DataAlignment) * TrainingFile::DataAlignment;
+			}
+
+			inline void ReadHeader( const unsigned char *data, size_t size, tHeader &header )
+			{
+				if ( size < HeaderSize || std::memcmp(data, Magic, sizeof(Magic)) != 0 )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::NetworkFile::ReadHeader(): Not a network file." );
+
+				header.Version = uint32_t( TrainingFile::Read(data + 8, 4) );
+				header.ValueType = uint32_t( TrainingFile::Read(data + 12, 4) );
+				header.Flags = uint32_t( TrainingFile::Read(data + 16, 4) );
+				size_t NumInputs = size_t( TrainingFile::Read(data + 20, 4) );
+				size_t NumOutputs = size_t( TrainingFile::Read(data + 24, 4) );
+				size_t NumHiddenLayers = size_t( TrainingFile::Read(data + 28, 4) );
+				uint64_t NumConnections = TrainingFile::Read( data + 32, 8 );
+				header.DataOffset = TrainingFile::Read( data + 40, 8 );
+
+				if ( header.Version != Version )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::NetworkFile::ReadHeader(): Unsupported network file version." );
+
+				TrainingFile::ValueSize( header.ValueType );		// Throws if it isn't one we know
+
+				size_t Offset = HeaderSize;
+
+				// Everything else is read through here, so a bad count can't take us past the end of the file
+				auto ReadNext = [data, size, &Offset]( size_t bytes ) -> uint64_t
+					{
+						if ( Offset + bytes > size )
+							throw std::runtime_error( "Toolbox::NeuralNetwork::NetworkFile::ReadHeader(): Network file is truncated." );
+
+						uint64_t Value = TrainingFile::Read( data + Offset, bytes );
+						Offset += bytes;
+						return Value;
+					};
+
+				header.InputLabels.clear();
+				header.OutputLabels.clear();
+				header.HiddenLayers.clear();
+				header.FirstDendrite.clear();
+				header.Source.clear();
+
+				for ( size_t l = 0; l < NumInputs + NumOutputs; ++l )
+				{
+					size_t Length = size_t( ReadNext(4) );
+
+					if ( Offset + Length > size )
+						throw std::runtime_error( "Toolbox::NeuralNetwork::NetworkFile::ReadHeader(): Network file is truncated." );
+
+					std::string Label( reinterpret_cast<const char *>(data + Offset), Length );
+					Offset += Length;
+
+					if ( l < NumInputs )
+						header.InputLabels.push_back( Label );
+					else
+						header.OutputLabels.push_back( Label );
+				}
+
+				size_t NumNeurons = 1 + NumInputs + NumOutputs;
+
+				for ( size_t l = 0; l < NumHiddenLayers; ++l )
+				{
+					tHiddenLayer CurLayer;
+					CurLayer.Index = ReadNext( 8 );
+
+					size_t CurNumNeurons = size_t( ReadNext(4) );
+
+					for ( size_t n = 0; n < CurNumNeurons; ++n )
+						CurLayer.Neurons.push_back( ReadNext(8) );
+
+					NumNeurons += CurNumNeurons;
+					header.HiddenLayers.push_back( CurLayer );
+				}
+
+				header.FirstDendrite.push_back( 0 );
+
+				for ( size_t n = 0; n < NumNeurons; ++n )
+				{
+					size_t NumDendrites = size_t( ReadNext(4) );
+
+					for ( size_t d = 0; d < NumDendrites; ++d )
+					{
+						uint32_t Source = uint32_t( ReadNext(4) );
+
+						if ( Source >= NumNeurons )
+							throw std::runtime_error( "Toolbox::NeuralNetwork::NetworkFile::ReadHeader(): Network file is corrupt." );
+
+						header.Source.push_back( Source );
+					}
+
+					header.FirstDendrite.push_back( header.Source.size() );
+				}
+
+				if ( header.Source.size() != NumConnections )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::NetworkFile::ReadHeader(): Network file is corrupt." );
+
+				if ( header.DataOffset < Offset || header.DataOffset > size )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::NetworkFile::ReadHeader(): Network file is truncated." );
+
+				// DataOffset comes straight from the file, so compare what's left rather than adding to it (EndOffset() could wrap around)
+				uint64_t NumValues = 2 + header.NumNeurons() + header.NumConnections();
+
+				if ( NumValues > (size - header.DataOffset) / TrainingFile::ValueSize(header.ValueType) )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::NetworkFile::ReadHeader(): Network file is truncated." );
+			}
+		}
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_NETWORKFILE_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
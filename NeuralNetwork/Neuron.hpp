@@ -36,6 +36,14 @@
  *   information, or even of multiple kinds of data simultaneously (with the
  *   help of a special custom datatype).
  *
+ * - FloatNucleus and FloatNeuron are the 'float' versions of the defaults
+ *   (with FloatGanglion, FloatTrainingSet and FloatTrainer to go with them).
+ *   Everything a float network does (activation, training, compiled and
+ *   vectorized layers) stays in float, so weights and values take half the
+ *   memory and each SIMD register holds twice as many of them.  The math
+ *   functions used by the default nucleus are the std:: overloads, which
+ *   pick the float versions (expf(), tanhf()) for float values.
+ *
  * - Custom nuclei are created by deriving tNucleus<> (with your preferred
  *   base tNeurotransmitter type) and overriding the functions provided
  *   via the tNucleus<> parent class.  A custom tNucleus<> MUST define the
@@ -47,6 +55,19 @@
  *   functions a programmer may want to customize for any particular Neuron
  *   (summation/activation/etc.)
  *
+ * - Nucleus is always an object of exactly the tNucleus<> type a tNeuron<> was
+ *   given, so tNeuron<> calls its functions directly (qualified calls, see
+ *   Accumulate(), Activate(), Derive(), ActivateLayer() and DeriveLayer())
+ *   rather than through the virtual table.  The compiler sees exactly which
+ *   function runs and can inline it into the processing loops, while custom
+ *   nuclei are still written the same way (overriding virtual functions).
+ *   Code working with a known neuron type should call these rather than
+ *   going through Nucleus itself.
+ *
+ * - Dendrites and Axons are std::pmr containers.  Neurons allocate their
+ *   connections from the heap by default, or from whatever memory resource
+ *   they are given when created (an Arena, for example -- see Arena.hpp).
+ *
  *****************************************************************************
 #if USE_DEFAULT_NEURON
     typedef Toolbox::NeuralNetwork::Neuron	Neuron;	// a.k.a. tNeuron< tNucleus<double> >
@@ -79,9 +100,11 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <random>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
 
 #include <cmath>
 
@@ -117,7 +140,7 @@ namespace Toolbox
 			template <typename tType>
 			tType Sigmoid( tType value )
 			{
-				return tType(1) / (tType(1) + exp(-value));
+				return tType(1) / (tType(1) + std::exp(-value));
 			}
 
 			template <typename tType>
@@ -129,7 +152,30 @@ namespace Toolbox
 			template <typename tType>
 			tType TanH( tType value )
 			{
-				return tanh( value );
+				return std::tanh( value );
+			}
+
+			// A whole layer at once -- Each result is exp( value ) over the sum of them all, worked out from (value - the largest value) so nothing can overflow ('result' may be 'values')
+			template <typename tType>
+			void Softmax( const tType *values, tType *result, size_t count )
+			{
+				if ( count == 0 )
+					return;
+
+				tType Largest = *std::max_element( values, values + count );
+				tType Total = tType();
+
+				for ( size_t v = 0; v < count; ++v )
+				{
+					result[ v ] = std::exp( values[v] - Largest );
+					Total += result[ v ];
+				}
+
+				// The largest value contributes exp( 0 ) == 1, so Total is never less than that
+				tType Scale = tType(1) / Total;
+
+				for ( size_t v = 0; v < count; ++v )
+					result[ v ] *= Scale;
 			}
 		}
 
@@ -198,11 +244,25 @@ namespace Toolbox
 				return Derivation::Sigmoid( value );
 				//return Derivation::TanH( value );
 			}
+
+			// Whole-layer versions of the above, used by flattened networks (see Compiled.hpp) -- Override these with batch/SIMD versions when available (see Vectorized.hpp)
+			virtual void ActivateLayer( const tNeurotransmitter *values, tNeurotransmitter *result, size_t count )
+			{
+				for ( size_t v = 0; v < count; ++v )
+					result[ v ] = this->Activation( values[v] );
+			}
+
+			virtual void DeriveLayer( const tNeurotransmitter *values, tNeurotransmitter *result, size_t count )
+			{
+				for ( size_t v = 0; v < count; ++v )
+					result[ v ] = this->Derivation( values[v] );
+			}
 		};
 
 
 		// Then define our default Nucleus
-		typedef tNucleus<>	Nucleus;
+		typedef tNucleus<>			Nucleus;
+		typedef tNucleus< float >	FloatNucleus;
 
 
 		// Neurons maintain both dendrites and axons to assist algorithms (like backprop) with neighbor neuron checking
@@ -215,9 +275,9 @@ namespace Toolbox
 
 			TOOLBOX_POINTERS( tNeuron )
 
-			typedef std::map< wPtr, tNeurotransmitter,
+			typedef std::pmr::map< wPtr, tNeurotransmitter,
 						std::owner_less<wPtr> >			tDendrites;	// Neuron inputs & weights
-			typedef std::list< wPtr >					tAxons;		// Neuron outputs
+			typedef std::pmr::list< wPtr >				tAxons;		// Neuron outputs
 
 		public:
 			tDendrites									Dendrites;
@@ -235,7 +295,10 @@ namespace Toolbox
 			{
 			}
 
-			_Neuron( const tNeurotransmitter &threshold ):
+			// 'memory' is where our dendrites and axons are allocated from
+			_Neuron( const tNeurotransmitter &threshold, std::pmr::memory_resource *memory = std::pmr::get_default_resource() ):
+				Dendrites( memory ),
+				Axons( memory ),
 				Threshold( threshold ),
 				_Processed( false ),
 				_Activated( false ),
@@ -472,8 +535,8 @@ namespace Toolbox
 			{
 			}
 
-			tNeuron( const tNeurotransmitter &threshold ):
-				tParent( threshold )
+			tNeuron( const tNeurotransmitter &threshold, std::pmr::memory_resource *memory = std::pmr::get_default_resource() ):
+				tParent( threshold, memory )
 			{
 			}
 
@@ -481,6 +544,45 @@ namespace Toolbox
 			{
 			}
 
+			// The nucleus' functions, resolved at compile time
+			static tNeurotransmitter Accumulate( std::shared_ptr< tParent > self )
+			{
+				return Nucleus.tNucleus::Accumulator( self );
+			}
+
+			static tNeurotransmitter Activate( tNeurotransmitter value )
+			{
+				return Nucleus.tNucleus::Activation( value );
+			}
+
+			static tNeurotransmitter Derive( tNeurotransmitter value )
+			{
+				return Nucleus.tNucleus::Derivation( value );
+			}
+
+			// Nuclei that don't provide their own whole-layer versions get a loop that calls the single-value version directly
+			static void ActivateLayer( const tNeurotransmitter *values, tNeurotransmitter *result, size_t count )
+			{
+				if constexpr ( _DefaultActivateLayer )
+				{
+					for ( size_t v = 0; v < count; ++v )
+						result[ v ] = Activate( values[v] );
+				}
+				else
+					Nucleus.tNucleus::ActivateLayer( values, result, count );
+			}
+
+			static void DeriveLayer( const tNeurotransmitter *values, tNeurotransmitter *result, size_t count )
+			{
+				if constexpr ( _DefaultDeriveLayer )
+				{
+					for ( size_t v = 0; v < count; ++v )
+						result[ v ] = Derive( values[v] );
+				}
+				else
+					Nucleus.tNucleus::DeriveLayer( values, result, count );
+			}
+
 			// Returns 'true' if the neuron fires during procesing
 			virtual bool Process( bool useThreshold = true )
 			{
@@ -492,7 +594,7 @@ namespace Toolbox
 				this->_CurValue = tNeurotransmitter();		// Zero out our value to prepare for our accumulator
 
 				// Update our value
-				this->_CurValue = this->Nucleus.Accumulator( this->shared_from_this() );
+				this->_CurValue = Accumulate( this->shared_from_this() );
 
 				// If we have no dendrites, assume we're an input/bias neuron and activate 100% of the time
 				if ( this->Dendrites.empty() )
@@ -500,7 +602,7 @@ namespace Toolbox
 				else
 				{
 					// Otherwise, run it through our activation function/check the threshold
-					this->_CurValue = this->Nucleus.Activation( this->_CurValue );
+					this->_CurValue = Activate( this->_CurValue );
 
 					// If we're not using a threshold (bias instead), or if we exceed the set threshold
 					if ( !useThreshold || this->_CurValue >= this->Threshold )
@@ -509,6 +611,14 @@ namespace Toolbox
 
 				return this->_Activated;
 			}
+
+		protected:
+			typedef Toolbox::NeuralNetwork::tNucleus< tNeurotransmitter >	tBaseNucleus;
+			typedef void (tBaseNucleus::*tLayerFunc)( const tNeurotransmitter *, tNeurotransmitter *, size_t );
+
+			// Whether the nucleus still uses tNucleus<>'s own whole-layer loops (&tNucleus::X names the class the function was last declared in)
+			static constexpr bool _DefaultActivateLayer = std::is_same< decltype(&tNucleus::ActivateLayer), tLayerFunc >::value;
+			static constexpr bool _DefaultDeriveLayer = std::is_same< decltype(&tNucleus::DeriveLayer), tLayerFunc >::value;
 		};
 
 
@@ -518,7 +628,8 @@ namespace Toolbox
 
 
 		// Then define our default Neuron type
-		typedef tNeuron<>	Neuron;
+		typedef tNeuron<>				Neuron;
+		typedef tNeuron< FloatNucleus >	FloatNeuron;
 
 
 		// Just like a standard neuron, but with an attached label for human-readability
@@ -545,8 +656,8 @@ namespace Toolbox
 			{
 			}
 
-			tLabeledNeuron( const std::string &label, const tNeurotransmitter &threshold = tNeurotransmitter() ):
-				tParent( threshold ),
+			tLabeledNeuron( const std::string &label, const tNeurotransmitter &threshold = tNeurotransmitter(), std::pmr::memory_resource *memory = std::pmr::get_default_resource() ):
+				tParent( threshold, memory ),
 				_Label( label )
 			{
 			}
@@ -570,6 +681,18 @@ namespace Toolbox
 		};
 
 
+		// Whether a neuron remembers earlier passes (like tRecurrentNeuron<>, see Recurrent.hpp) -- The flattened networks have nowhere to keep that memory, so they won't take these
+		template <typename tNeuron, typename = void>
+		struct tHasMemory : std::false_type
+		{
+		};
+
+		template <typename tNeuron>
+		struct tHasMemory< tNeuron, std::void_t<decltype(tNeuron::MemorySize)> > : std::true_type
+		{
+		};
+
+
 		// Then define our default LabeledNeuron type
 		typedef tLabeledNeuron<>	LabeledNeuron;
 	}
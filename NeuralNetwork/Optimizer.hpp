@@ -0,0 +1,334 @@
+#ifndef TOOLBOX_NEURALNETWORK_OPTIMIZER_HPP
+#define TOOLBOX_NEURALNETWORK_OPTIMIZER_HPP
+
+/*
+ * Toolbox/NeuralNetwork/Optimizer.hpp
+ *
+ * Turns the error gradients found during training into weight updates.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - The trainer numbers every weight it trains (0 to numWeights - 1) and
+ *   calls the optimizer with the gradient of the network error for each one.
+ *   The optimizer fills in how much each weight should change by.  Any state
+ *   an optimizer needs is kept per weight, in flat arrays indexed the same
+ *   way.
+ *
+ * - The trainer calls, in order:
+ *     Reset( numWeights )	Once, at the start of training
+ *     NewCycle()			At the start of each training cycle
+ *     NewUpdate()			Before each set of weight updates
+ *     Step( ... )			Once or more per update, for ranges of weights
+ *     Skip( ... )			For ranges of weights with nothing to update
+ *                          (neurons that didn't activate, for example)
+ *
+ * - tSGD<> is the default, and matches the original trainer exactly: the
+ *   whole of the previous update is carried forward (momentum), but only
+ *   within a single training cycle.
+ *
+ * - tNesterov<>, tRMSProp<> and tAdam<> are the usual adaptive methods.
+ *   They typically need a much smaller learning rate than tSGD<> (0.001 is a
+ *   good place to start with tAdam<>).
+ *
+ ****************************************************************************
+	Toolbox::NeuralNetwork::Trainer MyTrainer;
+
+	MyTrainer.Optimizer = std::make_shared< Toolbox::NeuralNetwork::Adam >();
+	MyTrainer.LearningRate = 0.01;
+
+	MyTrainer.Train( MyGanglion, MyTrainingSet );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <Toolbox/NeuralNetwork/Neuron.hpp>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tOptimizer
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+			typedef std::vector< tNeurotransmitter >		tValues;
+
+			TOOLBOX_POINTERS( tOptimizer<tNeurotransmitter> )
+
+		public:
+			tOptimizer()
+			{
+			}
+
+			virtual ~tOptimizer()
+			{
+			}
+
+			// Forget everything from any previous training
+			virtual void Reset( size_t numWeights ) = 0;
+
+			virtual void NewCycle()
+			{
+			}
+
+			virtual void NewUpdate()
+			{
+			}
+
+			// Fills in update[0..count) for the weights numbered first..first + count
+			virtual void Step( const tNeurotransmitter *gradient, tNeurotransmitter *update, size_t first, size_t count, tNeurotransmitter learningRate ) = 0;
+
+			virtual void Skip( size_t /*first*/, size_t /*count*/ )
+			{
+			}
+		};
+
+		typedef tOptimizer<>		Optimizer;
+
+
+		//
+		// Plain gradient descent, with the original trainer's momentum
+		//
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tSGD : public tOptimizer< _tNeurotransmitter >
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+			typedef tOptimizer< tNeurotransmitter >			tParent;
+			typedef typename tParent::tValues				tValues;
+
+			TOOLBOX_POINTERS( tSGD<tNeurotransmitter> )
+
+		public:
+			tNeurotransmitter		Momentum;		// How much of the previous update to carry forward
+
+		public:
+			tSGD( tNeurotransmitter momentum = tNeurotransmitter(1) ):
+				Momentum( momentum ),
+				_NumUpdates( 0 )
+			{
+			}
+
+			virtual void Reset( size_t numWeights )
+			{
+				_PrevUpdate.assign( numWeights, tNeurotransmitter() );
+				_NumUpdates = 0;
+			}
+
+			virtual void NewCycle()
+			{
+				_NumUpdates = 0;
+			}
+
+			virtual void NewUpdate()
+			{
+				++_NumUpdates;
+			}
+
+			virtual void Step( const tNeurotransmitter *gradient, tNeurotransmitter *update, size_t first, size_t count, tNeurotransmitter learningRate )
+			{
+				tNeurotransmitter *PrevUpdate = _PrevUpdate.data() + first;
+
+				for ( size_t w = 0; w < count; ++w )
+				{
+					update[ w ] = -learningRate * gradient[ w ];
+
+					// Verify we have a previous update (from this cycle) to work with for our momentum
+					if ( _NumUpdates > 1 )
+						update[ w ] += Momentum * PrevUpdate[ w ];
+
+					PrevUpdate[ w ] = update[ w ];
+				}
+			}
+
+			virtual void Skip( size_t first, size_t count )
+			{
+				std::fill( _PrevUpdate.begin() + first, _PrevUpdate.begin() + first + count, tNeurotransmitter() );
+			}
+
+		protected:
+			tValues					_PrevUpdate;
+			size_t					_NumUpdates;	// Since the start of the cycle
+		};
+
+		typedef tSGD<>				SGD;
+
+
+		//
+		// Momentum that looks ahead to where the weights are headed
+		//
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tNesterov : public tOptimizer< _tNeurotransmitter >
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+			typedef tOptimizer< tNeurotransmitter >			tParent;
+			typedef typename tParent::tValues				tValues;
+
+			TOOLBOX_POINTERS( tNesterov<tNeurotransmitter> )
+
+		public:
+			tNeurotransmitter		Momentum;
+
+		public:
+			tNesterov( tNeurotransmitter momentum = tNeurotransmitter(0.9) ):
+				Momentum( momentum )
+			{
+			}
+
+			virtual void Reset( size_t numWeights )
+			{
+				_Velocity.assign( numWeights, tNeurotransmitter() );
+			}
+
+			virtual void Step( const tNeurotransmitter *gradient, tNeurotransmitter *update, size_t first, size_t count, tNeurotransmitter learningRate )
+			{
+				tNeurotransmitter *Velocity = _Velocity.data() + first;
+
+				for ( size_t w = 0; w < count; ++w )
+				{
+					Velocity[ w ] = (Momentum * Velocity[w]) - (learningRate * gradient[w]);
+					update[ w ] = (Momentum * Velocity[w]) - (learningRate * gradient[w]);
+				}
+			}
+
+		protected:
+			tValues					_Velocity;
+		};
+
+		typedef tNesterov<>			Nesterov;
+
+
+		//
+		// Scales each weight's step by a running average of its recent gradients
+		//
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tRMSProp : public tOptimizer< _tNeurotransmitter >
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+			typedef tOptimizer< tNeurotransmitter >			tParent;
+			typedef typename tParent::tValues				tValues;
+
+			TOOLBOX_POINTERS( tRMSProp<tNeurotransmitter> )
+
+		public:
+			tNeurotransmitter		Decay;
+			tNeurotransmitter		Epsilon;
+
+		public:
+			tRMSProp( tNeurotransmitter decay = tNeurotransmitter(0.9), tNeurotransmitter epsilon = tNeurotransmitter(1e-8) ):
+				Decay( decay ),
+				Epsilon( epsilon )
+			{
+			}
+
+			virtual void Reset( size_t numWeights )
+			{
+				_MeanSquare.assign( numWeights, tNeurotransmitter() );
+			}
+
+			virtual void Step( const tNeurotransmitter *gradient, tNeurotransmitter *update, size_t first, size_t count, tNeurotransmitter learningRate )
+			{
+				tNeurotransmitter *MeanSquare = _MeanSquare.data() + first;
+
+				for ( size_t w = 0; w < count; ++w )
+				{
+					MeanSquare[ w ] = (Decay * MeanSquare[w]) + ((tNeurotransmitter(1) - Decay) * gradient[w] * gradient[w]);
+					update[ w ] = -learningRate * gradient[ w ] / (std::sqrt(MeanSquare[w]) + Epsilon);
+				}
+			}
+
+		protected:
+			tValues					_MeanSquare;
+		};
+
+		typedef tRMSProp<>			RMSProp;
+
+
+		//
+		// RMSProp plus momentum, with both corrected for starting out at zero
+		//
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tAdam : public tOptimizer< _tNeurotransmitter >
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+			typedef tOptimizer< tNeurotransmitter >			tParent;
+			typedef typename tParent::tValues				tValues;
+
+			TOOLBOX_POINTERS( tAdam<tNeurotransmitter> )
+
+		public:
+			tNeurotransmitter		Beta1;
+			tNeurotransmitter		Beta2;
+			tNeurotransmitter		Epsilon;
+
+		public:
+			tAdam( tNeurotransmitter beta1 = tNeurotransmitter(0.9), tNeurotransmitter beta2 = tNeurotransmitter(0.999), tNeurotransmitter epsilon = tNeurotransmitter(1e-8) ):
+				Beta1( beta1 ),
+				Beta2( beta2 ),
+				Epsilon( epsilon ),
+				_NumUpdates( 0 ),
+				_Correction1( tNeurotransmitter(1) ),
+				_Correction2( tNeurotransmitter(1) )
+			{
+			}
+
+			virtual void Reset( size_t numWeights )
+			{
+				_Mean.assign( numWeights, tNeurotransmitter() );
+				_MeanSquare.assign( numWeights, tNeurotransmitter() );
+				_NumUpdates = 0;
+			}
+
+			virtual void NewUpdate()
+			{
+				++_NumUpdates;
+
+				_Correction1 = tNeurotransmitter(1) - std::pow( Beta1, tNeurotransmitter(_NumUpdates) );
+				_Correction2 = tNeurotransmitter(1) - std::pow( Beta2, tNeurotransmitter(_NumUpdates) );
+			}
+
+			virtual void Step( const tNeurotransmitter *gradient, tNeurotransmitter *update, size_t first, size_t count, tNeurotransmitter learningRate )
+			{
+				tNeurotransmitter *Mean = _Mean.data() + first;
+				tNeurotransmitter *MeanSquare = _MeanSquare.data() + first;
+
+				for ( size_t w = 0; w < count; ++w )
+				{
+					Mean[ w ] = (Beta1 * Mean[w]) + ((tNeurotransmitter(1) - Beta1) * gradient[w]);
+					MeanSquare[ w ] = (Beta2 * MeanSquare[w]) + ((tNeurotransmitter(1) - Beta2) * gradient[w] * gradient[w]);
+
+					update[ w ] = -learningRate * (Mean[w] / _Correction1) / (std::sqrt(MeanSquare[w] / _Correction2) + Epsilon);
+				}
+			}
+
+		protected:
+			tValues					_Mean;
+			tValues					_MeanSquare;
+			size_t					_NumUpdates;
+			tNeurotransmitter		_Correction1;	// Bias corrections for the current update
+			tNeurotransmitter		_Correction2;
+		};
+
+		typedef tAdam<>				Adam;
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_OPTIMIZER_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
@@ -0,0 +1,252 @@
+#ifndef TOOLBOX_NEURALNETWORK_PROCESSINGORDER_HPP
+#define TOOLBOX_NEURALNETWORK_PROCESSINGORDER_HPP
+
+/*
+ * Toolbox/NeuralNetwork/ProcessingOrder.hpp
+ *
+ * Works out the order to process the neurons of a network in.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - A ProcessingOrder is built from numbered neurons and their axons (as
+ *   compressed sparse rows: where each neuron's axons start, and the number
+ *   of the neuron on the other end of each), along with which neurons are
+ *   the inputs.
+ *
+ * - Every neuron the inputs can reach is put in order after everything
+ *   feeding into it.  Neurons that feed back into each other (recurrent
+ *   loops, or a neuron connected to itself) can't be put in order, so they
+ *   are grouped together -- these are the strongly connected components of
+ *   the network, found with Tarjan's algorithm.  Everything else is a group
+ *   of its own.  Within a group, neurons keep the order they were found in
+ *   (breadth first from the inputs).
+ *
+ * - Each group's Level is the processing cycle its furthest input reaches it
+ *   in (the inputs are 0).  For a layered network, that's the layer.  Groups
+ *   are ordered by level, and nothing in one level feeds into anything else
+ *   in the same level -- so the groups within a level can be processed in
+ *   any order, or all at once (see tGanglion<>::UseWorkerPool()).
+ *
+ * - Neurons the inputs can't reach aren't part of the order at all.
+ *
+ * - See tGanglion<>::Process() and tSparseGanglion<>::Process().
+ *
+ ****************************************************************************
+	// A -> B -> C, with C feeding back into B
+	std::vector< size_t > FirstAxon = { 0, 1, 2, 3 }, Axon = { 1, 2, 1 }, Inputs = { 0 };
+
+	Toolbox::NeuralNetwork::ProcessingOrder Order;
+	Order.Build( FirstAxon, Axon, Inputs );
+
+	// Order.Order == { 0, 1, 2 }, with A in one group (Level 0) and B and C together in another (Level 1)
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <Toolbox/Defines.h>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		class ProcessingOrder
+		{
+		public:
+			TOOLBOX_POINTERS( ProcessingOrder )
+
+			static constexpr size_t		Unscheduled	= size_t( -1 );
+
+			// A run of neurons in the order that are processed together
+			struct tGroup
+			{
+				size_t		First;			// Into Order
+				size_t		Last;			// One past the end
+				size_t		Level;			// The processing cycle its furthest input reaches it in (the inputs are 0)
+			};
+
+		public:
+			std::vector< size_t >		Order;			// Neuron numbers, in processing order
+			std::vector< size_t >		Position;		// Per neuron -- Where it is in Order (Unscheduled if the inputs can't reach it)
+			std::vector< tGroup >		Groups;			// In processing order
+			std::vector< size_t >		Levels;			// Per level, plus one past the end -- Index into Groups
+
+		public:
+			ProcessingOrder()
+			{
+			}
+
+			virtual ~ProcessingOrder()
+			{
+			}
+
+			// 'firstAxon' has one entry per neuron plus one past the end, indexing into 'axon' -- Works with any unsigned index type
+			template <typename tIndices>
+			void Build( const tIndices &firstAxon, const tIndices &axon, const std::vector<size_t> &inputs )
+			{
+				size_t NumNeurons = (firstAxon.empty() ? 0 : firstAxon.size() - 1);
+
+				Order.clear();
+				Position.assign( NumNeurons, Unscheduled );
+				Groups.clear();
+				Levels.assign( 1, 0 );
+
+				// Number every neuron the inputs can reach, in the order they're found
+				std::vector< size_t > Found, Rank( NumNeurons, Unscheduled );
+
+				for ( auto i = inputs.begin(), i_end = inputs.end(); i != i_end; ++i )
+				{
+					if ( Rank[*i] == Unscheduled )
+					{
+						Rank[ *i ] = Found.size();
+						Found.push_back( *i );
+					}
+				}
+
+				for ( size_t f = 0; f < Found.size(); ++f )
+				{
+					for ( size_t a = size_t(firstAxon[Found[f]]), a_end = size_t(firstAxon[Found[f] + 1]); a < a_end; ++a )
+					{
+						size_t CurAxon = size_t( axon[a] );
+
+						if ( Rank[CurAxon] == Unscheduled )
+						{
+							Rank[ CurAxon ] = Found.size();
+							Found.push_back( CurAxon );
+						}
+					}
+				}
+
+				// Find the strongly connected components (without recursion, so large networks can't run out of stack) -- They come out with the last to be processed first
+				size_t NextIndex = 0, NumComponents = 0;
+				std::vector< size_t > Index( NumNeurons, Unscheduled ), LowLink( NumNeurons ), Component( NumNeurons, Unscheduled ), Stack;
+				std::vector< unsigned char > OnStack( NumNeurons, 0 );
+				std::vector< std::pair<size_t, size_t> > Path;		// The neurons we're in the middle of, and the next axon to follow from each
+
+				for ( auto Root = Found.begin(), Root_end = Found.end(); Root != Root_end; ++Root )
+				{
+					if ( Index[*Root] != Unscheduled )
+						continue;
+
+					Index[ *Root ] = LowLink[ *Root ] = NextIndex++;
+					Stack.push_back( *Root );
+					OnStack[ *Root ] = 1;
+					Path.push_back( std::make_pair(*Root, size_t(firstAxon[*Root])) );
+
+					while ( !Path.empty() )
+					{
+						size_t n = Path.back().first;
+
+						if ( Path.back().second < size_t(firstAxon[n + 1]) )
+						{
+							size_t m = size_t( axon[Path.back().second++] );
+
+							if ( Index[m] == Unscheduled )
+							{
+								Index[ m ] = LowLink[ m ] = NextIndex++;
+								Stack.push_back( m );
+								OnStack[ m ] = 1;
+								Path.push_back( std::make_pair(m, size_t(firstAxon[m])) );
+							}
+							else if ( OnStack[m] )
+								LowLink[ n ] = std::min( LowLink[n], Index[m] );
+
+							continue;
+						}
+
+						Path.pop_back();
+
+						if ( !Path.empty() )
+							LowLink[ Path.back().first ] = std::min( LowLink[Path.back().first], LowLink[n] );
+
+						if ( LowLink[n] == Index[n] )
+						{
+							size_t Member = Unscheduled;
+
+							do
+							{
+								Member = Stack.back();
+								Stack.pop_back();
+								OnStack[ Member ] = 0;
+								Component[ Member ] = NumComponents;
+							}
+							while ( Member != n );
+
+							++NumComponents;
+						}
+					}
+				}
+
+				// Turn the components around into processing order, keeping the neurons within each in the order they were found
+				for ( auto f = Found.begin(), f_end = Found.end(); f != f_end; ++f )
+					Component[ *f ] = NumComponents - 1 - Component[ *f ];
+
+				Order = Found;
+
+				std::sort( Order.begin(), Order.end(), [&Component, &Rank]( size_t lhs, size_t rhs )
+					{
+						return (Component[lhs] != Component[rhs] ? Component[lhs] < Component[rhs] : Rank[lhs] < Rank[rhs]);
+					} );
+
+				// Components come after everything feeding into them, so each one's level is settled by the time we get to it
+				std::vector< size_t > Level( NumComponents, 0 );
+
+				for ( auto n = Order.begin(), n_end = Order.end(); n != n_end; ++n )
+				{
+					for ( size_t a = size_t(firstAxon[*n]), a_end = size_t(firstAxon[*n + 1]); a < a_end; ++a )
+					{
+						size_t m = size_t( axon[a] );
+
+						if ( Component[m] != Component[*n] )
+							Level[ Component[m] ] = std::max( Level[Component[m]], Level[Component[*n]] + 1 );
+					}
+				}
+
+				// Then sort by level (which is still in order)
+				std::stable_sort( Order.begin(), Order.end(), [&Component, &Level]( size_t lhs, size_t rhs )
+					{
+						return Level[Component[lhs]] < Level[Component[rhs]];
+					} );
+
+				for ( size_t p = 0, p_end = Order.size(); p < p_end; ++p )
+				{
+					size_t n = Order[ p ];
+
+					Position[ n ] = p;
+
+					if ( p == 0 || Component[Order[p - 1]] != Component[n] )
+					{
+						tGroup CurGroup;
+						CurGroup.First = p;
+						CurGroup.Level = Level[ Component[n] ];
+
+						// Close off any levels we've moved past
+						while ( Levels.size() <= CurGroup.Level )
+							Levels.push_back( Groups.size() );
+
+						Groups.push_back( CurGroup );
+					}
+
+					Groups.back().Last = p + 1;
+				}
+
+				Levels.push_back( Groups.size() );
+			}
+		};
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_PROCESSINGORDER_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
@@ -0,0 +1,320 @@
+#ifndef TOOLBOX_NEURALNETWORK_PROFILE_HPP
+#define TOOLBOX_NEURALNETWORK_PROFILE_HPP
+
+/*
+ * Toolbox/NeuralNetwork/Profile.hpp
+ *
+ * Counters and timings from inside our ganglia and trainers.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - Profiling is compiled out unless TOOLBOX_NEURALNETWORK_PROFILE is
+ *   defined (before including any of the NeuralNetwork headers).  Without
+ *   it, the hooks in tGanglion<> and tTrainer<> don't exist at all -- Only
+ *   their (empty) Profiler pointers are left over.  Define it the same way
+ *   for every file in a program.
+ *
+ * - With it defined, give a ganglion and/or trainer a tProfiler<> (the same
+ *   one is fine) and they report to it:
+ *
+ *   - Every tGanglion<>::Process() -- How long it took, how many neurons
+ *     were processed, and how many processing cycles were used out of the
+ *     maxProcessingCycles allowed (Limited is set when the limit cut the
+ *     pass short).
+ *
+ *   - Every tTrainer<> training cycle (epoch) -- The set error, learning
+ *     rate, time spent in the forward pass, backward pass and applying the
+ *     weight updates, and the size of the weight updates (RMS and largest).
+ *     When training with Threads, the forward/backward times are added up
+ *     over all of the threads (CPU time rather than wall time).
+ *
+ * - Each report goes to Callback (if set) as it happens, is added to Totals,
+ *   and is kept (up to MaxEvents, unless KeepEvents is turned off) for
+ *   SaveTrace().  SaveTrace() writes the Chrome trace-event format, which
+ *   chrome://tracing or https://ui.perfetto.dev can open -- Passes and epochs
+ *   show up as spans, and the error and phase times as counters.
+ *
+ * - Reports are locked, so one profiler can be shared between networks on
+ *   different threads.
+ *
+ ****************************************************************************
+	#define TOOLBOX_NEURALNETWORK_PROFILE
+	#include <Toolbox/NeuralNetwork/Trainer.hpp>
+
+	auto MyProfiler = std::make_shared< Toolbox::NeuralNetwork::Profiler >();
+
+	MyProfiler->Callback = []( const Toolbox::NeuralNetwork::Profiler::tEvent &event )
+		{
+			if ( event.Type == Toolbox::NeuralNetwork::Profiler::EpochEvent )
+				std::cout << "Cycle " << event.Epoch.Cycle << "  Error: " << event.Epoch.Error << std::endl;
+		};
+
+	MyGanglion.Profiler = MyProfiler;
+	MyTrainer.Profiler = MyProfiler;
+	MyTrainer.Train( MyGanglion, MyTrainingSet );
+
+	MyProfiler->SaveTrace( "training.json" );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <Toolbox/NeuralNetwork/Neuron.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		namespace Default
+		{
+			const size_t MaxProfileEvents		= 100000;		// Events kept for SaveTrace() (each Process() is one)
+		}
+
+
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tProfiler
+		{
+		public:
+			typedef _tNeurotransmitter				tNeurotransmitter;
+			typedef tProfiler< tNeurotransmitter >	ttProfiler;
+			typedef std::chrono::steady_clock		tClock;
+
+			TOOLBOX_POINTERS( ttProfiler )
+
+			enum tEventType
+			{
+				PassEvent,			// A tGanglion<>::Process()
+				EpochEvent			// A tTrainer<> training cycle
+			};
+
+			struct tPass
+			{
+				size_t				Neurons;		// Neurons processed
+				size_t				Cycles;			// Processing cycles used (the inputs count as the first)
+				size_t				MaxCycles;		// maxProcessingCycles (0 means no limit)
+				bool				Limited;		// MaxCycles stopped something from being processed
+			};
+
+			struct tEpoch
+			{
+				size_t				Cycle;			// Counting from 0
+				size_t				Records;
+				tNeurotransmitter	Error;			// The whole training set's
+				tNeurotransmitter	LearningRate;
+				double				ForwardTime;	// Microseconds
+				double				BackwardTime;
+				double				ApplyTime;
+				size_t				Updates;		// Weight updates applied (each weight counts once per update)
+				tNeurotransmitter	UpdateRMS;		// Root-mean-square of those updates
+				tNeurotransmitter	MaxUpdate;		// The largest (absolute) one
+			};
+
+			struct tEvent
+			{
+				tEventType			Type;
+				double				Start;			// Microseconds since the profiler started (or was Reset())
+				double				Duration;		// Microseconds
+				size_t				Thread;			// Numbered from 1, in the order threads first reported
+				tPass				Pass;			// When Type == PassEvent
+				tEpoch				Epoch;			// When Type == EpochEvent
+			};
+
+			struct tTotals
+			{
+				size_t				Passes;
+				size_t				Neurons;
+				size_t				LimitedPasses;
+				double				ProcessTime;	// Microseconds
+				size_t				Epochs;
+				double				ForwardTime;
+				double				BackwardTime;
+				double				ApplyTime;
+			};
+
+			typedef std::function< void(const tEvent &) >	tCallback;
+
+		public:
+			tCallback				Callback;		// Sees every event, as it happens (on the reporting thread)
+			bool					KeepEvents;		// Keep events for Events() and SaveTrace()
+			size_t					MaxEvents;		// Stop keeping them after this many (Callback and Totals still see everything)
+			tTotals					Totals;
+
+		public:
+			tProfiler():
+				KeepEvents( true ),
+				MaxEvents( Default::MaxProfileEvents )
+			{
+				Reset();
+			}
+
+			virtual ~tProfiler()
+			{
+			}
+
+			void Reset()
+			{
+				std::lock_guard< std::mutex > Lock( _Mutex );
+
+				Totals = tTotals();
+				_Events.clear();
+				_Threads.clear();
+				_Start = tClock::now();
+			}
+
+			// Microseconds since the profiler started -- Reports use this for their start times
+			double Now() const
+			{
+				return std::chrono::duration< double, std::micro >( tClock::now() - _Start ).count();
+			}
+
+			void AddPass( double start, const tPass &pass )
+			{
+				tEvent Event = tEvent();
+				Event.Type = PassEvent;
+				Event.Pass = pass;
+
+				{
+					std::lock_guard< std::mutex > Lock( _Mutex );
+
+					_stamp( Event, start );
+
+					++Totals.Passes;
+					Totals.Neurons += pass.Neurons;
+					Totals.LimitedPasses += (pass.Limited ? 1 : 0);
+					Totals.ProcessTime += Event.Duration;
+
+					_keep( Event );
+				}
+
+				if ( Callback )
+					Callback( Event );
+			}
+
+			void AddEpoch( double start, const tEpoch &epoch )
+			{
+				tEvent Event = tEvent();
+				Event.Type = EpochEvent;
+				Event.Epoch = epoch;
+
+				{
+					std::lock_guard< std::mutex > Lock( _Mutex );
+
+					_stamp( Event, start );
+
+					++Totals.Epochs;
+					Totals.ForwardTime += epoch.ForwardTime;
+					Totals.BackwardTime += epoch.BackwardTime;
+					Totals.ApplyTime += epoch.ApplyTime;
+
+					_keep( Event );
+				}
+
+				if ( Callback )
+					Callback( Event );
+			}
+
+			// Not locked -- Don't call while something is still reporting
+			const std::vector< tEvent > &Events() const
+			{
+				return _Events;
+			}
+
+			// Chrome trace-event format (JSON)
+			void WriteTrace( std::ostream &out ) const
+			{
+				std::lock_guard< std::mutex > Lock( _Mutex );
+
+				out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+				bool First = true;
+
+				for ( auto e = _Events.begin(), e_end = _Events.end(); e != e_end; ++e )
+				{
+					out << (First ? "\n" : ",\n");
+					First = false;
+
+					if ( e->Type == PassEvent )
+					{
+						out << "{\"name\":\"Process\",\"cat\":\"ganglion\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e->Thread << ",\"ts\":" << e->Start << ",\"dur\":" << e->Duration
+							<< ",\"args\":{\"neurons\":" << e->Pass.Neurons << ",\"cycles\":" << e->Pass.Cycles << ",\"max_cycles\":" << e->Pass.MaxCycles << ",\"limited\":" << (e->Pass.Limited ? "true" : "false") << "}}";
+						continue;
+					}
+
+					const tEpoch &Epoch = e->Epoch;
+
+					out << "{\"name\":\"Epoch\",\"cat\":\"trainer\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e->Thread << ",\"ts\":" << e->Start << ",\"dur\":" << e->Duration
+						<< ",\"args\":{\"cycle\":" << Epoch.Cycle << ",\"records\":" << Epoch.Records << ",\"error\":" << Epoch.Error << ",\"learning_rate\":" << Epoch.LearningRate
+						<< ",\"forward_us\":" << Epoch.ForwardTime << ",\"backward_us\":" << Epoch.BackwardTime << ",\"apply_us\":" << Epoch.ApplyTime
+						<< ",\"updates\":" << Epoch.Updates << ",\"update_rms\":" << Epoch.UpdateRMS << ",\"max_update\":" << Epoch.MaxUpdate << "}},\n";
+
+					// Counters are drawn as graphs along the timeline
+					out << "{\"name\":\"Error\",\"ph\":\"C\",\"pid\":1,\"ts\":" << (e->Start + e->Duration) << ",\"args\":{\"error\":" << Epoch.Error << "}},\n";
+					out << "{\"name\":\"Epoch time (us)\",\"ph\":\"C\",\"pid\":1,\"ts\":" << (e->Start + e->Duration) << ",\"args\":{\"forward\":" << Epoch.ForwardTime << ",\"backward\":" << Epoch.BackwardTime << ",\"apply\":" << Epoch.ApplyTime << "}},\n";
+					out << "{\"name\":\"Update size\",\"ph\":\"C\",\"pid\":1,\"ts\":" << (e->Start + e->Duration) << ",\"args\":{\"rms\":" << Epoch.UpdateRMS << ",\"max\":" << Epoch.MaxUpdate << "}}";
+				}
+
+				out << "\n]}\n";
+			}
+
+			void SaveTrace( const std::string &fileName ) const
+			{
+				std::ofstream File( fileName );
+
+				if ( !File )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tProfiler<>::SaveTrace(): Unable to open '" + fileName + "'." );
+
+				WriteTrace( File );
+			}
+
+		protected:
+			tClock::time_point						_Start;
+			std::vector< tEvent >					_Events;
+			std::map< std::thread::id, size_t >		_Threads;
+			mutable std::mutex						_Mutex;
+
+		protected:
+			void _stamp( tEvent &event, double start )
+			{
+				event.Start = start;
+				event.Duration = Now() - start;
+
+				auto Thread = _Threads.find( std::this_thread::get_id() );
+
+				if ( Thread == _Threads.end() )
+					Thread = _Threads.insert( std::make_pair(std::this_thread::get_id(), _Threads.size() + 1) ).first;
+
+				event.Thread = Thread->second;
+			}
+
+			void _keep( const tEvent &event )
+			{
+				if ( KeepEvents && _Events.size() < MaxEvents )
+					_Events.push_back( event );
+			}
+		};
+
+		typedef tProfiler<>		Profiler;
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_PROFILE_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
@@ -0,0 +1,605 @@
+#ifndef TOOLBOX_NEURALNETWORK_QUANTIZED_HPP
+#define TOOLBOX_NEURALNETWORK_QUANTIZED_HPP
+
+/*
+ * Toolbox/NeuralNetwork/Quantized.hpp
+ *
+ * Integer (int8/int16) versions of trained networks, for fast inference.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - tQuantizedGanglion<> is built from a trained, layered network (through
+ *   a compiled copy of it, see Compiled.hpp) and a calibration set of
+ *   typical inputs.  It only runs the network forward -- Train the original,
+ *   then quantize it again.
+ *
+ * - Each layer's weights are stored as int8_t (or int16_t) values with one
+ *   scale factor for the whole layer (the largest weight maps to 127, or
+ *   32767).  Each layer's inputs get their own scale factor the same way,
+ *   from the largest value the calibration set produced there.  Anything
+ *   bigger is clamped.
+ *
+ * - Each neuron's weighted sum is a single integer dot product (AVX2 or
+ *   SSE2 when available, see Vectorized.hpp), with the bias added in the
+ *   same integer units.  int8_t sums are 32 bits wide and int16_t sums are
+ *   64 bits wide, so neither can overflow.
+ *
+ * - The activation function is never called while processing.  Each layer
+ *   has a lookup table of TableSize entries covering the sums seen during
+ *   calibration (plus some room either side), worked out once through the
+ *   nucleus' own ActivateLayer().  A hidden layer's table holds values that
+ *   are already quantized for the next layer.  Sums outside of the table are
+ *   clamped to its ends, which suits squashing functions (sigmoid, tanh)
+ *   much better than Linear ones.
+ *
+ * - With SoftmaxOutput, the output layer has no table -- Its sums are
+ *   scaled back up and put through the softmax together, as in the original.
+ *
+ * - Only networks using a bias can be quantized, and every pass runs all of
+ *   the layers (there is no maxProcessingCycles).  Processing reuses buffers
+ *   kept in the object, so each thread needs its own copy.
+ *
+ * - Report() runs a set of inputs through both the quantized network and
+ *   the original, and compares the results.
+ *
+ ****************************************************************************
+	Ganglion MyGanglion;
+	// ... Create, connect and train the network as usual ...
+
+	// Some typical inputs (row-major, one column per input in label order) to work out the ranges from
+	std::vector< double > Calibration = { ... };
+
+	Toolbox::NeuralNetwork::tQuantizedGanglion< Neuron, int8_t > Quantized( MyGanglion, Calibration );
+
+	// See how much was lost, on data that wasn't used for calibration
+	auto Report = Quantized.Report( MyGanglion.Compile(), TestInputs );
+	std::cout << "Worst output error: " << Report.MaxError << std::endl;
+
+	// And then use it just like a compiled network
+	Quantized.ProcessBatch( Inputs, Outputs );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <Toolbox/NeuralNetwork/Compiled.hpp>
+#include <Toolbox/NeuralNetwork/Vectorized.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		namespace Default
+		{
+			const size_t QuantizedTableSize		= 4096;		// Entries in each layer's activation lookup table
+		}
+
+
+		namespace SIMD
+		{
+			// Quantized rows (and inputs) are padded out with zeros to a multiple of this, so the dot products never have leftovers to deal with
+			const size_t QuantizedPadding		= 32;
+
+			// Integer dot products -- 'count' should be a multiple of QuantizedPadding
+			inline int32_t Dot( const int8_t *a, const int8_t *b, size_t count )
+			{
+				size_t i = 0;
+				int32_t Sum = 0;
+
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+	#if defined(__AVX2__)
+				__m256i Acc = _mm256_setzero_si256();
+
+				for ( ; i + 16 <= count; i += 16 )
+				{
+					__m256i A = _mm256_cvtepi8_epi16( _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)) );
+					__m256i B = _mm256_cvtepi8_epi16( _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)) );
+					Acc = _mm256_add_epi32( Acc, _mm256_madd_epi16(A, B) );
+				}
+
+				__m128i Half = _mm_add_epi32( _mm256_castsi256_si128(Acc), _mm256_extracti128_si256(Acc, 1) );
+	#else
+				__m128i Half = _mm_setzero_si128();
+
+				for ( ; i + 16 <= count; i += 16 )
+				{
+					__m128i A = _mm_loadu_si128( reinterpret_cast<const __m128i *>(a + i) );
+					__m128i B = _mm_loadu_si128( reinterpret_cast<const __m128i *>(b + i) );
+
+					// Sign extend to 16 bits (each byte lands in the top half of a 16 bit lane, then shifts back down)
+					__m128i ALo = _mm_srai_epi16( _mm_unpacklo_epi8(A, A), 8 );
+					__m128i AHi = _mm_srai_epi16( _mm_unpackhi_epi8(A, A), 8 );
+					__m128i BLo = _mm_srai_epi16( _mm_unpacklo_epi8(B, B), 8 );
+					__m128i BHi = _mm_srai_epi16( _mm_unpackhi_epi8(B, B), 8 );
+
+					Half = _mm_add_epi32( Half, _mm_add_epi32(_mm_madd_epi16(ALo, BLo), _mm_madd_epi16(AHi, BHi)) );
+				}
+	#endif
+				Half = _mm_add_epi32( Half, _mm_shuffle_epi32(Half, _MM_SHUFFLE(1, 0, 3, 2)) );
+				Half = _mm_add_epi32( Half, _mm_shuffle_epi32(Half, _MM_SHUFFLE(2, 3, 0, 1)) );
+				Sum = _mm_cvtsi128_si32( Half );
+#endif
+
+				for ( ; i < count; ++i )
+					Sum += int32_t( a[i] ) * int32_t( b[i] );
+
+				return Sum;
+			}
+
+			// Pairs of 16 bit products still fit in 32 bits (the values never reach -32768), but the running sum needs 64
+			inline int64_t Dot( const int16_t *a, const int16_t *b, size_t count )
+			{
+				size_t i = 0;
+				int64_t Sum = 0;
+
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+				alignas( 32 ) int64_t Lanes[ 4 ] = { 0, 0, 0, 0 };
+
+	#if defined(__AVX2__)
+				__m256i Acc = _mm256_setzero_si256();
+
+				for ( ; i + 16 <= count; i += 16 )
+				{
+					__m256i Pairs = _mm256_madd_epi16( _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)) );
+
+					Acc = _mm256_add_epi64( Acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(Pairs)) );
+					Acc = _mm256_add_epi64( Acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(Pairs, 1)) );
+				}
+
+				_mm256_store_si256( reinterpret_cast<__m256i *>(Lanes), Acc );
+	#else
+				__m128i Acc = _mm_setzero_si128();
+
+				for ( ; i + 8 <= count; i += 8 )
+				{
+					__m128i Pairs = _mm_madd_epi16( _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)) );
+					__m128i Sign = _mm_srai_epi32( Pairs, 31 );
+
+					Acc = _mm_add_epi64( Acc, _mm_unpacklo_epi32(Pairs, Sign) );
+					Acc = _mm_add_epi64( Acc, _mm_unpackhi_epi32(Pairs, Sign) );
+				}
+
+				_mm_store_si128( reinterpret_cast<__m128i *>(Lanes), Acc );
+	#endif
+				Sum = Lanes[ 0 ] + Lanes[ 1 ] + Lanes[ 2 ] + Lanes[ 3 ];
+#endif
+
+				for ( ; i < count; ++i )
+					Sum += int32_t( a[i] ) * int32_t( b[i] );
+
+				return Sum;
+			}
+		}
+
+
+		// What each weight type is summed up in, and its largest (symmetric) value
+		template <typename tWeight> struct tQuantizedTraits;
+
+		template <>
+		struct tQuantizedTraits< int8_t >
+		{
+			typedef int32_t			tAccumulator;
+			static const int32_t	Max = 127;
+		};
+
+		template <>
+		struct tQuantizedTraits< int16_t >
+		{
+			typedef int64_t			tAccumulator;
+			static const int32_t	Max = 32767;
+		};
+
+
+		template <typename _tNeuron = Neuron, typename _tWeight = int8_t>
+		class tQuantizedGanglion
+		{
+		public:
+			typedef _tNeuron										ttNeuron;
+			typedef _tWeight										tWeight;
+			typedef typename ttNeuron::tNeurotransmitter			tNeurotransmitter;
+			typedef typename tQuantizedTraits<tWeight>::tAccumulator	tAccumulator;
+			typedef tCompiledGanglion< ttNeuron >					ttCompiledGanglion;
+			typedef tQuantizedGanglion< ttNeuron, tWeight >			ttQuantizedGanglion;
+
+			TOOLBOX_POINTERS( ttQuantizedGanglion )
+
+			typedef std::vector< tNeurotransmitter >				tValues;
+			typedef std::vector< tWeight >							tWeights;
+
+			static const int32_t									MaxWeight = tQuantizedTraits< tWeight >::Max;
+
+			struct tLayer
+			{
+				size_t						NumInputs;		// Width of the previous layer
+				size_t						NumNeurons;
+				size_t						Stride;			// NumInputs, padded (see SIMD::QuantizedPadding)
+
+				tNeurotransmitter			WeightScale;	// What a weight of 1 stands for
+				tNeurotransmitter			InputScale;		// What an input of 1 stands for
+
+				tWeights					Weights;		// Row-major, NumNeurons x Stride
+				std::vector< tAccumulator >	Bias;			// In sum units (WeightScale * InputScale)
+
+				tAccumulator				TableMin;		// Sums are clamped to TableMin..TableMax
+				tAccumulator				TableMax;
+				unsigned int				Shift;			// Each table entry covers (1 << Shift) sum units
+				tWeights					Table;			// Hidden layers -- Activated values, in the next layer's InputScale
+				tValues						OutputTable;	// The output layer -- Activated values (empty with SoftmaxOutput)
+			};
+
+			// How the quantized network compares to the original
+			struct tReport
+			{
+				size_t						NumRecords;
+				tNeurotransmitter			MaxError;		// Largest difference between any two outputs
+				tNeurotransmitter			MeanError;		// Average difference, over every output of every record
+				tNeurotransmitter			RMSError;
+				tNeurotransmitter			Agreement;		// Fraction of records whose largest output is the same one in both
+				size_t						OriginalBytes;	// Weights and biases of the original
+				size_t						QuantizedBytes;	// Weights, biases and tables of the quantized network
+			};
+
+		public:
+			std::vector< std::string >		InputLabels;	// In the same order as the ganglion's Input map
+			std::vector< std::string >		OutputLabels;	// In the same order as the ganglion's Output map
+
+			std::vector< tLayer >			Layers;			// Hidden layers (in order), followed by the output layer
+			size_t							TableSize;		// Most entries in each lookup table (set before calling Quantize())
+			bool							SoftmaxOutput;	// Copied from the original -- The output layer is a softmax over its sums
+
+		public:
+			tQuantizedGanglion():
+				TableSize( Default::QuantizedTableSize ),
+				SoftmaxOutput( false )
+			{
+			}
+
+			tQuantizedGanglion( const ttCompiledGanglion &original, const tValues &calibration, size_t tableSize = Default::QuantizedTableSize ):
+				TableSize( tableSize ),
+				SoftmaxOutput( false )
+			{
+				Quantize( original, calibration );
+			}
+
+			template <typename tGanglion>
+			tQuantizedGanglion( const tGanglion &network, const tValues &calibration, size_t tableSize = Default::QuantizedTableSize ):
+				TableSize( tableSize ),
+				SoftmaxOutput( false )
+			{
+				Quantize( ttCompiledGanglion(network), calibration );
+			}
+
+			virtual ~tQuantizedGanglion()
+			{
+			}
+
+			// 'calibration' is row-major (one column per input, in InputLabels order), and should cover the range of inputs the network will see
+			void Quantize( const ttCompiledGanglion &original, const tValues &calibration )
+			{
+				if ( original.Layers.empty() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tQuantizedGanglion<>::Quantize(): Network has not been compiled." );
+
+				if ( !original.UseBias )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tQuantizedGanglion<>::Quantize(): Network must use a bias." );
+
+				const size_t NumIn = original.NumInputs();
+
+				if ( NumIn == 0 || calibration.empty() || (calibration.size() % NumIn) != 0 )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tQuantizedGanglion<>::Quantize(): Calibration size is not a multiple of the number of inputs." );
+
+				if ( TableSize < 2 )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tQuantizedGanglion<>::Quantize(): TableSize must be at least 2." );
+
+				const size_t NumLayers = original.Layers.size();
+
+				InputLabels = original.InputLabels;
+				OutputLabels = original.OutputLabels;
+				SoftmaxOutput = original.SoftmaxOutput;
+				Layers.assign( NumLayers, tLayer() );
+
+				// Run the calibration set through the original to see what ranges each layer works in
+				tNeurotransmitter MaxInput = tNeurotransmitter();
+				tValues SumMin( NumLayers, std::numeric_limits<tNeurotransmitter>::max() );
+				tValues SumMax( NumLayers, std::numeric_limits<tNeurotransmitter>::lowest() );
+				tValues MaxValue( NumLayers, tNeurotransmitter() );
+
+				typename ttCompiledGanglion::tState State;
+				original.NewState( State );
+
+				for ( size_t r = 0, r_end = calibration.size() / NumIn; r < r_end; ++r )
+				{
+					std::copy( calibration.begin() + (r * NumIn), calibration.begin() + ((r + 1) * NumIn), State.Input.begin() );
+					original.Process( State, 0 );
+
+					for ( size_t i = 0; i < NumIn; ++i )
+						MaxInput = std::max( MaxInput, tNeurotransmitter(std::abs(State.Input[i])) );
+
+					for ( size_t l = 0; l < NumLayers; ++l )
+					{
+						for ( size_t n = 0, n_end = State.Sum[l].size(); n < n_end; ++n )
+						{
+							SumMin[ l ] = std::min( SumMin[l], State.Sum[l][n] );
+							SumMax[ l ] = std::max( SumMax[l], State.Sum[l][n] );
+							MaxValue[ l ] = std::max( MaxValue[l], tNeurotransmitter(std::abs(State.Value[l][n])) );
+						}
+					}
+				}
+
+				for ( size_t l = 0; l < NumLayers; ++l )
+				{
+					const auto &Original = original.Layers[ l ];
+					tLayer &CurLayer = Layers[ l ];
+
+					CurLayer.NumInputs = Original.NumInputs;
+					CurLayer.NumNeurons = Original.NumNeurons;
+					CurLayer.Stride = _padded( Original.NumInputs );
+					CurLayer.InputScale = _scale( l == 0 ? MaxInput : MaxValue[l - 1] );
+
+					tNeurotransmitter MaxAbsWeight = tNeurotransmitter();
+
+					for ( auto w = Original.Weights.begin(), w_end = Original.Weights.end(); w != w_end; ++w )
+						MaxAbsWeight = std::max( MaxAbsWeight, tNeurotransmitter(std::abs(*w)) );
+
+					CurLayer.WeightScale = _scale( MaxAbsWeight );
+					CurLayer.Weights.assign( CurLayer.NumNeurons * CurLayer.Stride, tWeight() );
+					CurLayer.Bias.assign( CurLayer.NumNeurons, tAccumulator() );
+
+					const tNeurotransmitter SumScale = CurLayer.WeightScale * CurLayer.InputScale;
+
+					for ( size_t n = 0; n < CurLayer.NumNeurons; ++n )
+					{
+						for ( size_t i = 0; i < CurLayer.NumInputs; ++i )
+							CurLayer.Weights[ (n * CurLayer.Stride) + i ] = _quantize( Original.Weights[(n * CurLayer.NumInputs) + i], CurLayer.WeightScale );
+
+						CurLayer.Bias[ n ] = tAccumulator( std::llround(Original.Bias[n] * original.BiasValue / SumScale) );
+					}
+
+					// The table covers the sums seen, with an extra eighth of the range (and at least one unit) either side
+					if ( CurLayer.NumNeurons == 0 )
+					{
+						SumMin[ l ] = tNeurotransmitter();
+						SumMax[ l ] = tNeurotransmitter();
+					}
+
+					tNeurotransmitter Margin = ((SumMax[l] - SumMin[l]) / tNeurotransmitter(8)) + SumScale;
+
+					CurLayer.TableMin = tAccumulator( std::floor((SumMin[l] - Margin) / SumScale) );
+					CurLayer.TableMax = tAccumulator( std::ceil((SumMax[l] + Margin) / SumScale) );
+					CurLayer.Shift = 0;
+
+					while ( size_t((CurLayer.TableMax - CurLayer.TableMin) >> CurLayer.Shift) + 1 > TableSize )
+						++CurLayer.Shift;
+
+					// Activate the middle of each entry's range, all at once
+					const size_t NumEntries = size_t( (CurLayer.TableMax - CurLayer.TableMin) >> CurLayer.Shift ) + 1;
+					const tAccumulator Half = (tAccumulator(1) << CurLayer.Shift) / 2;
+					tValues Entries( NumEntries );
+
+					for ( size_t e = 0; e < NumEntries; ++e )
+						Entries[ e ] = tNeurotransmitter( CurLayer.TableMin + (tAccumulator(e) << CurLayer.Shift) + Half ) * SumScale;
+
+					ttNeuron::ActivateLayer( Entries.data(), Entries.data(), NumEntries );
+
+					if ( l + 1 == NumLayers )
+					{
+						if ( !SoftmaxOutput )
+							CurLayer.OutputTable = Entries;
+
+						continue;
+					}
+
+					const tNeurotransmitter NextScale = _scale( MaxValue[l] );
+					CurLayer.Table.resize( NumEntries );
+
+					for ( size_t e = 0; e < NumEntries; ++e )
+						CurLayer.Table[ e ] = _quantize( Entries[e], NextScale );
+				}
+
+				_prepareBuffers();
+			}
+
+			size_t NumInputs() const
+			{
+				return InputLabels.size();
+			}
+
+			size_t NumOutputs() const
+			{
+				return OutputLabels.size();
+			}
+
+			// A single pass -- 'input' holds NumInputs() values (in InputLabels order), and 'output' receives NumOutputs() values (in OutputLabels order)
+			void Process( const tNeurotransmitter *input, tNeurotransmitter *output )
+			{
+				if ( Layers.empty() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tQuantizedGanglion<>::Process(): Network has not been quantized." );
+
+				const tNeurotransmitter InputScale = Layers.front().InputScale;
+				tWeight *In = _Buffer[ 0 ].data();
+
+				for ( size_t i = 0, i_end = Layers.front().NumInputs; i < i_end; ++i )
+					In[ i ] = _quantize( input[i], InputScale );
+
+				for ( size_t l = 0, l_end = Layers.size(); l < l_end; ++l )
+				{
+					const tLayer &CurLayer = Layers[ l ];
+					const tWeight *Weight = CurLayer.Weights.data();
+					const bool Last = (l + 1 == l_end);
+					tWeight *Out = _Buffer[ (l + 1) % 2 ].data();
+
+					for ( size_t n = 0; n < CurLayer.NumNeurons; ++n, Weight += CurLayer.Stride )
+					{
+						tAccumulator Sum = SIMD::Dot( Weight, In, CurLayer.Stride ) + CurLayer.Bias[ n ];
+
+						if ( Last && SoftmaxOutput )
+						{
+							output[ n ] = tNeurotransmitter( Sum ) * (CurLayer.WeightScale * CurLayer.InputScale);
+							continue;
+						}
+
+						size_t Entry = size_t( (std::min(std::max(Sum, CurLayer.TableMin), CurLayer.TableMax) - CurLayer.TableMin) >> CurLayer.Shift );
+
+						if ( Last )
+							output[ n ] = CurLayer.OutputTable[ Entry ];
+						else
+							Out[ n ] = CurLayer.Table[ Entry ];
+					}
+
+					In = Out;
+				}
+
+				if ( SoftmaxOutput )
+					Activation::Softmax( output, output, Layers.back().NumNeurons );
+			}
+
+			// Many passes -- 'inputs' is row-major (numRecords x NumInputs()) and 'outputs' receives numRecords x NumOutputs() values
+			void ProcessBatch( const tNeurotransmitter *inputs, size_t numRecords, tNeurotransmitter *outputs )
+			{
+				const size_t NumIn = NumInputs();
+				const size_t NumOut = NumOutputs();
+
+				for ( size_t r = 0; r < numRecords; ++r )
+					Process( inputs + (r * NumIn), outputs + (r * NumOut) );
+			}
+
+			void ProcessBatch( const tValues &inputs, tValues &outputs )
+			{
+				if ( NumInputs() == 0 || (inputs.size() % NumInputs()) != 0 )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tQuantizedGanglion<>::ProcessBatch(): Input size is not a multiple of the number of inputs." );
+
+				size_t NumRecords = inputs.size() / NumInputs();
+				outputs.resize( NumRecords * NumOutputs() );
+
+				ProcessBatch( inputs.data(), NumRecords, outputs.data() );
+			}
+
+			// Compares our outputs with the original network's for each record in 'inputs' (row-major, like ProcessBatch())
+			tReport Report( const ttCompiledGanglion &original, const tValues &inputs )
+			{
+				const size_t NumIn = NumInputs();
+				const size_t NumOut = NumOutputs();
+
+				if ( original.NumInputs() != NumIn || original.NumOutputs() != NumOut || original.Layers.size() != Layers.size() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tQuantizedGanglion<>::Report(): Network does not match." );
+
+				tReport Result = tReport();
+				tValues Outputs;
+				ProcessBatch( inputs, Outputs );
+
+				Result.NumRecords = inputs.size() / NumIn;
+
+				typename ttCompiledGanglion::tState State;
+				original.NewState( State );
+
+				size_t NumAgreed = 0;
+				tNeurotransmitter SumError = tNeurotransmitter(), SumSquared = tNeurotransmitter();
+
+				for ( size_t r = 0; r < Result.NumRecords; ++r )
+				{
+					std::copy( inputs.begin() + (r * NumIn), inputs.begin() + ((r + 1) * NumIn), State.Input.begin() );
+					original.Process( State, 0 );
+
+					const tValues &Expected = State.Value.back();
+					const tNeurotransmitter *Output = Outputs.data() + (r * NumOut);
+
+					for ( size_t o = 0; o < NumOut; ++o )
+					{
+						tNeurotransmitter Error = std::abs( Output[o] - Expected[o] );
+
+						Result.MaxError = std::max( Result.MaxError, Error );
+						SumError += Error;
+						SumSquared += Error * Error;
+					}
+
+					if ( NumOut != 0 && std::max_element(Output, Output + NumOut) - Output == std::max_element(Expected.begin(), Expected.end()) - Expected.begin() )
+						++NumAgreed;
+				}
+
+				const size_t NumValues = Result.NumRecords * NumOut;
+
+				if ( NumValues != 0 )
+				{
+					Result.MeanError = SumError / tNeurotransmitter( NumValues );
+					Result.RMSError = std::sqrt( SumSquared / tNeurotransmitter(NumValues) );
+					Result.Agreement = tNeurotransmitter( NumAgreed ) / tNeurotransmitter( Result.NumRecords );
+				}
+
+				Result.OriginalBytes = 0;
+
+				for ( auto l = original.Layers.begin(), l_end = original.Layers.end(); l != l_end; ++l )
+					Result.OriginalBytes += (l->Weights.size() + l->Bias.size()) * sizeof( tNeurotransmitter );
+
+				Result.QuantizedBytes = Bytes();
+
+				return Result;
+			}
+
+			// How much memory our weights, biases and tables take up
+			size_t Bytes() const
+			{
+				size_t Total = 0;
+
+				for ( auto l = Layers.begin(), l_end = Layers.end(); l != l_end; ++l )
+					Total += ((l->Weights.size() + l->Table.size()) * sizeof(tWeight)) + (l->Bias.size() * sizeof(tAccumulator)) + (l->OutputTable.size() * sizeof(tNeurotransmitter));
+
+				return Total;
+			}
+
+		protected:
+			tWeights						_Buffer[ 2 ];		// Each layer's quantized inputs during Process() (reused between calls)
+
+		protected:
+			static size_t _padded( size_t count )
+			{
+				return ((count + SIMD::QuantizedPadding - 1) / SIMD::QuantizedPadding) * SIMD::QuantizedPadding;
+			}
+
+			// The scale that maps 'maxValue' onto MaxWeight
+			static tNeurotransmitter _scale( tNeurotransmitter maxValue )
+			{
+				if ( !(maxValue > tNeurotransmitter()) )
+					return tNeurotransmitter( 1 );
+
+				return maxValue / tNeurotransmitter( MaxWeight );
+			}
+
+			static tWeight _quantize( tNeurotransmitter value, tNeurotransmitter scale )
+			{
+				long long Quantized = std::llround( value / scale );
+				return tWeight( std::min<long long>(std::max<long long>(Quantized, -MaxWeight), MaxWeight) );
+			}
+
+			// Room for the widest layer's inputs -- The padding past each layer's own inputs only ever meets zero weights
+			void _prepareBuffers()
+			{
+				size_t Widest = 0;
+
+				for ( auto l = Layers.begin(), l_end = Layers.end(); l != l_end; ++l )
+					Widest = std::max( Widest, std::max(l->Stride, l->NumNeurons) );
+
+				_Buffer[ 0 ].assign( Widest, tWeight() );
+				_Buffer[ 1 ].assign( Widest, tWeight() );
+			}
+		};
+
+		typedef tQuantizedGanglion<>		QuantizedGanglion;
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_QUANTIZED_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
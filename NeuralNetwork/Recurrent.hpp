@@ -11,15 +11,43 @@
 /****************************************************************************
  * Notes:
  *
- * ***** THIS IS CURRENTLY UNTESTED *****
- *
  * - Please see the documentation included with Ganglion.hpp for more info.
  *
+ * - Each recurrent neuron remembers its summed (pre-activation) value from
+ *   the last _MemorySize passes, and adds them back in to its next sum:
+ *   MemoryWeight[0] weighs the value from the previous pass, MemoryWeight[1]
+ *   the one before that, and so on.  ClearMemory() forgets them all (at the
+ *   start of a new sequence, for example).
+ *
+ * - The memory is a fixed ring of _MemorySize values inside each neuron, so
+ *   processing never allocates anything for it.  Memory( k ) reads the value
+ *   from k + 1 passes ago.
+ *
+ * - ProcessSequence() steps the network through a whole sequence of inputs
+ *   (one row per pass) and collects the outputs of every pass, starting
+ *   from a cleared memory unless told otherwise.
+ *
+ * - tTrainer<> doesn't know about time, so it never changes MemoryWeight.
+ *   Use tRecurrentTrainer<> to train both the dendrite and memory weights
+ *   over sequences (see RecurrentTrainer.hpp).
+ *
+ ****************************************************************************
+	typedef Toolbox::NeuralNetwork::tRecurrent< 4 >		Recurrent4;	// Remembers the last 4 passes
+
+	Recurrent4 MyNetwork;
+	// ... Create, connect and train the network as usual ...
+
+	// Run a whole sequence at once (row-major, one column per input in label order)
+	std::vector< double > Inputs = { 0.1, 0.2,   0.3, 0.4,   0.5, 0.6 }, Outputs;
+	MyNetwork.ProcessSequence( Inputs, Outputs );
+
  ****************************************************************************/
+/****************************************************************************/
 
 
 #include <Toolbox/NeuralNetwork/Ganglion.hpp>
 
+#include <array>
 #include <vector>
 
 
@@ -35,7 +63,7 @@ namespace Toolbox
 
 
 		//
-		// Helps to create a special recurrency-aware neuron
+		// The memory is kept (and added in) by tRecurrentNeuron itself, so any nucleus will do -- This one is kept around for existing code that names it
 		//
 		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
 		class tRecurrentNucleus : public tNucleus< _tNeurotransmitter >
@@ -43,9 +71,6 @@ namespace Toolbox
 		public:
 			typedef _tNeurotransmitter				tNeurotransmitter;
 			typedef tNucleus< tNeurotransmitter >	tParent;
-
-			// Defined below tRecurrentNeuron
-			virtual tNeurotransmitter Accumulator( std::shared_ptr< _Neuron<tNeurotransmitter> > self );
 		};
 
 		typedef tRecurrentNucleus<>			RecurrentNucleus;
@@ -65,19 +90,26 @@ namespace Toolbox
 
 			TOOLBOX_POINTERS( tSelf )
 
+			static constexpr size_t						MemorySize = _MemorySize;
+
 		public:
-			std::list< tNeurotransmitter >				Memory;
-			std::vector< tNeurotransmitter >			MemoryWeight;
+			std::array< tNeurotransmitter, _MemorySize >	MemoryWeight;	// MemoryWeight[k] weighs Memory( k )
 
 		public:
 			tRecurrentNeuron():
-				MemoryWeight( _MemorySize )
+				MemoryWeight(),
+				_Memory(),
+				_Newest( 0 ),
+				_Remembered( 0 )
 			{
 			}
 
-			tRecurrentNeuron( const tNeurotransmitter &threshold ):
-				tParent( threshold ),
-				MemoryWeight( _MemorySize )
+			tRecurrentNeuron( const tNeurotransmitter &threshold, std::pmr::memory_resource *memory = std::pmr::get_default_resource() ):
+				tParent( threshold, memory ),
+				MemoryWeight(),
+				_Memory(),
+				_Newest( 0 ),
+				_Remembered( 0 )
 			{
 			}
 
@@ -88,6 +120,23 @@ namespace Toolbox
 				return label.str();
 			}
 
+			// How many passes we remember so far (up to MemorySize)
+			size_t MemoryCount() const
+			{
+				return _Remembered;
+			}
+
+			// Our summed value from k + 1 passes ago -- Only good for k < MemoryCount()
+			const tNeurotransmitter &Memory( size_t k ) const
+			{
+				return _Memory[ (_Newest + _MemorySize - k) % _MemorySize ];
+			}
+
+			void ClearMemory()
+			{
+				_Remembered = 0;
+			}
+
 			virtual bool Process( bool useThreshold = true )
 			{
 				// Can't just call the parent since we need to borrow the value, so we've got to essentially copy the content so we can add what we need
@@ -100,14 +149,27 @@ namespace Toolbox
 				this->_CurValue = tNeurotransmitter();		// Zero out our value to prepare for our accumulator
 
 				// Update our value
-				this->_CurValue = this->Nucleus.Accumulator( this->shared_from_this() );
+				this->_CurValue = tParent::Accumulate( this->shared_from_this() );
 
 				////////////////////////////////////////
 				// Recurrency
-				Memory.push_back( this->_CurValue );
+				if constexpr ( _MemorySize > 0 )
+				{
+					tNeurotransmitter Recalled = tNeurotransmitter();
+
+					// Newest first, walking backwards around the ring
+					for ( size_t k = 0, m = _Newest; k < _Remembered; ++k, m = (m == 0 ? _MemorySize - 1 : m - 1) )
+						Recalled += _Memory[ m ] * MemoryWeight[ k ];
+
+					this->_CurValue += Recalled;
+
+					// Then remember this pass, in place of the oldest
+					_Newest = (_Newest + 1 == _MemorySize ? 0 : _Newest + 1);
+					_Memory[ _Newest ] = this->_CurValue;
 
-				if ( Memory.size() > _MemorySize )
-					Memory.pop_front();
+					if ( _Remembered < _MemorySize )
+						++_Remembered;
+				}
 				////////////////////////////////////////
 
 				// If we have no dendrites, assume we're an input/bias neuron and activate 100% of the time
@@ -116,7 +178,7 @@ namespace Toolbox
 				else
 				{
 					// Otherwise, run it through our activation function/check the threshold
-					this->_CurValue = this->Nucleus.Activation( this->_CurValue );
+					this->_CurValue = tParent::Activate( this->_CurValue );
 
 					// If we're not using a threshold (bias instead), or if we exceed the set threshold
 					if ( !useThreshold || this->_CurValue >= this->Threshold )
@@ -125,36 +187,16 @@ namespace Toolbox
 
 				return this->_Activated;
 			}
-	
-			friend class tRecurrentNucleus< tNeurotransmitter >;
+
+		protected:
+			std::array< tNeurotransmitter, _MemorySize >	_Memory;		// Ring of our summed values, _Memory[_Newest] being the latest
+			size_t											_Newest;
+			size_t											_Remembered;
 		};
 
 		typedef tRecurrentNeuron<>	RecurrentNeuron;
 
 
-		//
-		// Definition of the RecurrentNucleus activation function, now that we have our RecurrentNeuron available for use
-		//
-		template <typename tNeurotransmitter>
-		tNeurotransmitter tRecurrentNucleus<tNeurotransmitter>::Accumulator( std::shared_ptr< _Neuron<tNeurotransmitter> > self )
-		{
-			tNeurotransmitter Value = tParent::Accumulator( self );
-
-			typedef tRecurrentNeuron< tRecurrentNucleus<tNeurotransmitter> >	tExpectedType;
-			typename tExpectedType::Ptr Self = std::dynamic_pointer_cast< tExpectedType >( self );
-
-			if ( Self )
-			{
-				// Recurrency
-				size_t mw = 0;
-				for ( auto m = Self->Memory.begin(), m_end = Self->Memory.end(); m != m_end; ++m, ++mw )
-					Value += (*m) * Self->MemoryWeight[mw];
-			}
-
-			return Value;
-		}
-
-
 		//
 		// And finally, our recurrent neural network
 		//
@@ -165,8 +207,88 @@ namespace Toolbox
 			typedef _tNeuron							ttNeuron;
 			typedef tGanglion< ttNeuron >				tParent;
 			typedef tRecurrent< _MemorySize, ttNeuron >	tSelf;
+			typedef typename tParent::tNeurotransmitter	tNeurotransmitter;
+			typedef std::vector< tNeurotransmitter >	tValues;
 
 			TOOLBOX_POINTERS( tSelf )
+
+			static constexpr size_t						MemorySize = _MemorySize;
+
+		public:
+			// Memory moves on every pass, so there's never anything an incremental pass could skip
+			virtual void Process( size_t maxProcessingCycles = Default::MaxProcessingCycles )
+			{
+				// The outputs' sums include their memories, which tGanglion<> can't gather up again for the softmax
+				if ( this->SoftmaxOutput )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tRecurrent<>::Process(): SoftmaxOutput isn't supported by recurrent networks." );
+
+				this->Invalidate();
+				tParent::Process( maxProcessingCycles );
+			}
+
+			// Steps the network through a whole sequence -- 'inputs' is row-major (numPasses x the number of Inputs, in label order) and 'outputs' receives numPasses x the number of Outputs (in label order)
+			void ProcessSequence( const tNeurotransmitter *inputs, size_t numPasses, tNeurotransmitter *outputs, size_t maxProcessingCycles = Default::MaxProcessingCycles, bool clearMemory = true )
+			{
+				// Reuses the same space every call
+				_SequenceInputs.clear();
+				_SequenceOutputs.clear();
+
+				for ( auto i = this->Input.begin(), i_end = this->Input.end(); i != i_end; ++i )
+					_SequenceInputs.push_back( i->second.get() );
+
+				for ( auto o = this->Output.begin(), o_end = this->Output.end(); o != o_end; ++o )
+					_SequenceOutputs.push_back( o->second.get() );
+
+				const size_t NumIn = _SequenceInputs.size();
+				const size_t NumOut = _SequenceOutputs.size();
+
+				if ( clearMemory )
+					ClearMemory();
+
+				for ( size_t p = 0; p < numPasses; ++p, inputs += NumIn, outputs += NumOut )
+				{
+					for ( size_t i = 0; i < NumIn; ++i )
+						_SequenceInputs[ i ]->SetValue( inputs[i] );
+
+					this->Process( maxProcessingCycles );
+
+					for ( size_t o = 0; o < NumOut; ++o )
+						outputs[ o ] = _SequenceOutputs[ o ]->Value();
+				}
+			}
+
+			void ProcessSequence( const tValues &inputs, tValues &outputs, size_t maxProcessingCycles = Default::MaxProcessingCycles, bool clearMemory = true )
+			{
+				if ( this->Input.empty() || (inputs.size() % this->Input.size()) != 0 )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tRecurrent<>::ProcessSequence(): Input size is not a multiple of the number of inputs." );
+
+				size_t NumPasses = inputs.size() / this->Input.size();
+				outputs.resize( NumPasses * this->Output.size() );
+
+				ProcessSequence( inputs.data(), NumPasses, outputs.data(), maxProcessingCycles, clearMemory );
+			}
+
+			// Forgets every neuron's memory, as if the network had never been processed
+			void ClearMemory()
+			{
+				this->BiasNeuron->ClearMemory();
+
+				for ( auto i = this->Input.begin(), i_end = this->Input.end(); i != i_end; ++i )
+					i->second->ClearMemory();
+
+				for ( auto l = this->Hidden.begin(), l_end = this->Hidden.end(); l != l_end; ++l )
+				{
+					for ( auto h = l->second.begin(), h_end = l->second.end(); h != h_end; ++h )
+						h->second->ClearMemory();
+				}
+
+				for ( auto o = this->Output.begin(), o_end = this->Output.end(); o != o_end; ++o )
+					o->second->ClearMemory();
+			}
+
+		protected:
+			std::vector< typename tParent::ttLabeledNeuron * >	_SequenceInputs;	// In label order
+			std::vector< typename tParent::ttLabeledNeuron * >	_SequenceOutputs;	// In label order
 		};
 
 		typedef tRecurrent<>	Recurrent;
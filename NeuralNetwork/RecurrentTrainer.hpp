@@ -0,0 +1,586 @@
+#ifndef TOOLBOX_NEURALNETWORK_RECURRENTTRAINER_HPP
+#define TOOLBOX_NEURALNETWORK_RECURRENTTRAINER_HPP
+
+/*
+ * Toolbox/NeuralNetwork/RecurrentTrainer.hpp
+ *
+ * Trains recurrent networks over sequences, via truncated backpropagation
+ * through time.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - A tRecurrent<> network's output depends on what it has seen before, so
+ *   its training set is read as one or more sequences: every SequenceLength
+ *   records make up a sequence (0 makes the whole set a single sequence),
+ *   and the records of a sequence are fed to the network one per pass, in
+ *   order.  Each sequence starts from a cleared memory.
+ *
+ * - Each sequence is split into windows of Window passes (the network's
+ *   memory size by default).  Once a window has been processed, its errors
+ *   are carried back through every pass in it, into both the dendrite
+ *   weights and the memory weights (MemoryWeight).  Anything before the
+ *   window is treated as fixed -- That is the "truncated" part.
+ *
+ * - The values the network went through are kept in flat ring buffers with
+ *   room for one window plus the network's memory, all allocated once per
+ *   training run.
+ *
+ * - Train() updates the weights after every window, BatchTrain() after the
+ *   whole set, and MiniBatchTrain() after every BatchSize windows.  Shuffle
+ *   shuffles the order of the sequences (never the records within them).
+ *   The Optimizer, Schedule, validation set, Patience and RestoreBest all
+ *   work the same as they do for tTrainer<>.  Validate() also runs the set
+ *   as sequences.
+ *
+ * - A neuron's memory is fed back into its sum without going through the
+ *   activation function, so recurrent networks usually need a smaller
+ *   LearningRate than feed-forward ones (0.03 or so with tSGD<>).
+ *
+ * - Every neuron needs to be processed on every pass, so the network must
+ *   use a bias rather than thresholds.  Threads and Dropout are ignored
+ *   (training happens on the calling thread).  L1, L2 and WeightDecay cover
+ *   the memory weights as well as the dendrites.
+ *
+ ****************************************************************************
+	typedef Toolbox::NeuralNetwork::tRecurrent< 4 >		Recurrent4;
+
+	Recurrent4 MyNetwork;
+	// ... Set up the network ...
+
+	// 100 records per sequence, errors carried back 8 passes at a time
+	Toolbox::NeuralNetwork::tRecurrentTrainer< Recurrent4 > MyTrainer;
+	MyTrainer.SequenceLength = 100;
+	MyTrainer.Window = 8;
+
+	MyTrainer.Train( MyNetwork, MyTrainingSet, &Error, &Cycles );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <Toolbox/NeuralNetwork/Recurrent.hpp>
+#include <Toolbox/NeuralNetwork/Trainer.hpp>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		namespace Default
+		{
+			const size_t SequenceLength		= 0;				// Records per training sequence (0 makes the whole set one sequence)
+		}
+
+
+		template <typename _tRecurrent = Recurrent>
+		class tRecurrentTrainer : public tTrainer< _tRecurrent >
+		{
+		public:
+			typedef _tRecurrent									ttRecurrent;
+			typedef tTrainer< ttRecurrent >						tParent;
+			typedef typename tParent::tNeurotransmitter			tNeurotransmitter;
+			typedef typename tParent::ttTrainingSet				ttTrainingSet;
+			typedef typename tParent::ttOptimizer				ttOptimizer;
+			typedef typename tParent::tValues					tValues;
+			typedef typename ttRecurrent::ttNeuron				ttRecurrentNeuron;
+
+			TOOLBOX_POINTERS( tRecurrentTrainer<ttRecurrent> )
+
+			static constexpr size_t								MemorySize = ttRecurrent::MemorySize;
+
+		public:
+			size_t												SequenceLength;		// Records per sequence -- 0 makes the whole set one sequence
+			size_t												Window;				// Passes to carry the errors back through at once
+
+		public:
+			tRecurrentTrainer():
+				SequenceLength( Default::SequenceLength ),
+				Window( MemorySize )
+			{
+			}
+
+			tRecurrentTrainer( const tNeurotransmitter &learningRate, const tNeurotransmitter &momentum = tNeurotransmitter(Default::Momentum), const tNeurotransmitter &marginOfError = tNeurotransmitter(Default::AllowedError), size_t maxTrainingCycles = Default::MaxTrainingCycles, size_t maxProcessingCycles = Default::MaxProcessingCycles ):
+				tParent( learningRate, momentum, marginOfError, maxTrainingCycles, maxProcessingCycles ),
+				SequenceLength( Default::SequenceLength ),
+				Window( MemorySize )
+			{
+			}
+
+			virtual ~tRecurrentTrainer()
+			{
+			}
+
+			// Incremental training updates the weights after each window, whereas batch training only updates after the entire set has been seen
+			virtual bool Train( ttRecurrent &network, const ttTrainingSet &set, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL, bool incrementalTraining = true )
+			{
+				return _trainSequences( network, set, NULL, networkError, numCycles, incrementalTraining ? 1 : 0 );
+			}
+
+			virtual bool Train( ttRecurrent &network, const ttTrainingSet &set, const ttTrainingSet &validation, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL, bool incrementalTraining = true )
+			{
+				return _trainSequences( network, set, &validation, networkError, numCycles, incrementalTraining ? 1 : 0 );
+			}
+
+			// Updates the weights after every BatchSize windows
+			bool MiniBatchTrain( ttRecurrent &network, const ttTrainingSet &set, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL )
+			{
+				if ( this->BatchSize == 0 )
+					throw std::runtime_error("Toolbox::NeuralNetwork::RecurrentTrainer::MiniBatchTrain(): BatchSize must be at least 1.");
+
+				return _trainSequences( network, set, NULL, networkError, numCycles, this->BatchSize );
+			}
+
+			bool MiniBatchTrain( ttRecurrent &network, const ttTrainingSet &set, const ttTrainingSet &validation, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL )
+			{
+				if ( this->BatchSize == 0 )
+					throw std::runtime_error("Toolbox::NeuralNetwork::RecurrentTrainer::MiniBatchTrain(): BatchSize must be at least 1.");
+
+				return _trainSequences( network, set, &validation, networkError, numCycles, this->BatchSize );
+			}
+
+			// Checks a data set (as sequences) and returns the network error for the set
+			bool Validate( ttRecurrent &network, const ttTrainingSet &set = ttTrainingSet(), tNeurotransmitter *error = NULL )
+			{
+				tNeurotransmitter SetError = tNeurotransmitter();
+				auto Binding = set.Bind( network );
+				tInputNeurons InputNeurons;
+				std::vector< std::pair<typename ttRecurrent::ttLabeledNeuron *, size_t> > OutputNeurons;
+
+				_bindInputs( network, Binding, InputNeurons );
+
+				size_t CurOutput = 0;
+				for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o, ++CurOutput )
+				{
+					if ( Binding.Output[CurOutput] != ttTrainingSet::NoColumn )
+						OutputNeurons.push_back( std::make_pair(o->second.get(), Binding.Output[CurOutput]) );
+				}
+
+				for ( size_t CurRecord = 0, TrainingSetSize = set.Size(); CurRecord < TrainingSetSize; ++CurRecord )
+				{
+					if ( _sequenceStart(CurRecord) )
+						network.ClearMemory();
+
+					auto Record = set.Record( CurRecord );
+
+					for ( auto i = InputNeurons.begin(), i_end = InputNeurons.end(); i != i_end; ++i )
+						i->first->SetValue( Record.Input[i->second] );
+
+					network.Process( this->MaxProcessingCycles );
+
+					for ( auto o = OutputNeurons.begin(), o_end = OutputNeurons.end(); o != o_end; ++o )
+						SetError += this->CalculateError( o->first->Value() - Record.Output[o->second] );
+				}
+
+				if ( error != NULL )
+					*error = SetError;
+
+				return SetError <= this->AllowedError;
+			}
+
+		protected:
+			typedef typename tParent::tGraphIndex				tGraphIndex;
+			typedef typename tParent::tTrainingNeuron			tTrainingNeuron;
+			typedef std::vector< std::pair<typename ttRecurrent::ttLabeledNeuron *, size_t> >	tInputNeurons;
+
+			// The last Window + MemorySize passes through the network, one row per pass (pass 'p' of a sequence lives in row p % Capacity)
+			struct tHistory
+			{
+				size_t									Capacity;
+				size_t									NumValues;		// Per Value row -- The trained neurons (in tGraphIndex order), then anything else feeding them
+				size_t									NumNeurons;		// Per Sum/Delta row -- The trained neurons
+
+				std::vector< const _Neuron<tNeurotransmitter> * >	Tracked;	// Per Value column
+				std::vector< ttRecurrentNeuron * >		Neuron;			// Per trained neuron
+				std::vector< size_t >					Column;			// Per dendrite -- The Value column of the neuron on the other end
+
+				tValues									Value;			// Each neuron's value after each pass
+				tValues									Sum;			// Each trained neuron's summed value (what went into its memory) after each pass
+				tValues									Delta;			// Each trained neuron's error * derivation, worked out going backwards through a window
+				std::vector< const tNeurotransmitter * >	Target;		// Per row -- The training set's outputs for the pass
+			};
+
+		protected:
+			bool _sequenceStart( size_t record ) const
+			{
+				return (SequenceLength == 0 ? record == 0 : (record % SequenceLength) == 0);
+			}
+
+			void _bindInputs( ttRecurrent &network, const typename ttTrainingSet::tBinding &binding, tInputNeurons &inputNeurons )
+			{
+				size_t CurInput = 0;
+				for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i, ++CurInput )
+				{
+					if ( binding.Input[CurInput] != ttTrainingSet::NoColumn )
+						inputNeurons.push_back( std::make_pair(i->second.get(), binding.Input[CurInput]) );
+				}
+			}
+
+			// Lays out the history for the neurons in 'index' (which must be numbered the way tTrainer<>::_indexNetwork() numbers them)
+			void _buildHistory( ttRecurrent &network, const tGraphIndex &index, tHistory &history )
+			{
+				std::map< const _Neuron<tNeurotransmitter> *, size_t > Columns;
+
+				history = tHistory();
+				history.Capacity = Window + MemorySize;
+				history.NumNeurons = index.Neurons.size();
+
+				for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
+					history.Neuron.push_back( o->second.get() );
+
+				for ( auto l = network.Hidden.rbegin(), l_end = network.Hidden.rend(); l != l_end; ++l )
+				{
+					for ( auto h = l->second.begin(), h_end = l->second.end(); h != h_end; ++h )
+						history.Neuron.push_back( h->second.get() );
+				}
+
+				for ( size_t n = 0; n < history.NumNeurons; ++n )
+				{
+					Columns[ index.Neurons[n].Neuron.get() ] = n;
+					history.Tracked.push_back( index.Neurons[n].Neuron.get() );
+				}
+
+				for ( auto s = index.Source.begin(), s_end = index.Source.end(); s != s_end; ++s )
+				{
+					auto Column = Columns.find( *s );
+
+					if ( Column == Columns.end() )
+					{
+						Column = Columns.insert( std::make_pair(*s, history.Tracked.size()) ).first;
+						history.Tracked.push_back( *s );
+					}
+
+					history.Column.push_back( Column->second );
+				}
+
+				history.NumValues = history.Tracked.size();
+				history.Value.assign( history.Capacity * history.NumValues, tNeurotransmitter() );
+				history.Sum.assign( history.Capacity * history.NumNeurons, tNeurotransmitter() );
+				history.Delta.assign( history.Capacity * history.NumNeurons, tNeurotransmitter() );
+				history.Target.assign( history.Capacity, NULL );
+			}
+
+			// Copies what the network just did (on pass 'pass' of the current sequence) into the history
+			void _record( tHistory &history, size_t pass, const tNeurotransmitter *target )
+			{
+				const size_t Row = pass % history.Capacity;
+				tNeurotransmitter *Value = &history.Value[ Row * history.NumValues ];
+				tNeurotransmitter *Sum = &history.Sum[ Row * history.NumNeurons ];
+
+				for ( size_t v = 0; v < history.NumValues; ++v )
+					Value[ v ] = history.Tracked[ v ]->Value();
+
+				for ( size_t n = 0; n < history.NumNeurons; ++n )
+					Sum[ n ] = (history.Neuron[n]->MemoryCount() != 0 ? history.Neuron[n]->Memory(0) : tNeurotransmitter());
+
+				history.Target[ Row ] = target;
+			}
+
+			// Carries the errors back through passes first..last of the current sequence, adding to the gradients -- Returns the network error of those passes
+			tNeurotransmitter _backpropagate( const tGraphIndex &index, tHistory &history, size_t first, size_t last, tValues &gradient, tValues &memoryGradient, std::vector<unsigned char> &updated )
+			{
+				typedef typename ttRecurrent::ttNeuron		tTrainedNeuron;
+
+				const size_t NumNeurons = history.NumNeurons;
+				tNeurotransmitter WindowError = tNeurotransmitter();
+
+				for ( size_t t = last; t-- > first; )
+				{
+					const size_t Row = t % history.Capacity;
+					const tNeurotransmitter *Value = &history.Value[ Row * history.NumValues ];
+					const tNeurotransmitter *Target = history.Target[ Row ];
+					tNeurotransmitter *Delta = &history.Delta[ Row * NumNeurons ];
+
+					// The outputs come first in our index, then the hidden layers (in reverse order), so this works backwards through the network
+					for ( size_t n = 0; n < NumNeurons; ++n )
+					{
+						const tTrainingNeuron &CurNeuron = index.Neurons[ n ];
+						const ttRecurrentNeuron &CurRecurrent = *(history.Neuron[ n ]);
+						tNeurotransmitter CurError = tNeurotransmitter();
+
+						if ( n < index.NumOutputs )
+						{
+							if ( CurNeuron.Target == ttTrainingSet::NoColumn )
+							{
+								Delta[ n ] = tNeurotransmitter();
+								continue;
+							}
+
+							CurError = Value[ n ] - Target[ CurNeuron.Target ];
+							WindowError += this->CalculateError( CurError );
+						}
+						else
+						{
+							// Gather the total weighted error for this neuron from each of its axons (already worked out for this pass)
+							for ( size_t a = CurNeuron.FirstAxon, a_end = CurNeuron.FirstAxon + CurNeuron.NumAxons; a < a_end; ++a )
+								CurError += Delta[ index.AxonNeuron[a] ] * *(index.AxonWeight[ a ]);
+						}
+
+						tNeurotransmitter CurDelta = CurError * tTrainedNeuron::Derive( Value[n] );
+
+						// Our sum is fed straight back into our own later passes (within the window) through our memory
+						for ( size_t k = 1; k <= MemorySize && t + k < last; ++k )
+							CurDelta += history.Delta[ ((t + k) % history.Capacity) * NumNeurons + n ] * CurRecurrent.MemoryWeight[ k - 1 ];
+
+						Delta[ n ] = CurDelta;
+
+						for ( size_t d = CurNeuron.FirstDendrite, d_end = CurNeuron.FirstDendrite + CurNeuron.NumDendrites; d < d_end; ++d )
+							gradient[ d ] += CurDelta * Value[ history.Column[d] ];
+
+						// Memory from before the start of the sequence is always zero
+						for ( size_t k = 1; k <= MemorySize && k <= t; ++k )
+							memoryGradient[ (n * MemorySize) + k - 1 ] += CurDelta * history.Sum[ ((t - k) % history.Capacity) * NumNeurons + n ];
+
+						updated[ n ] = true;
+					}
+				}
+
+				return WindowError;
+			}
+
+			void _applyUpdates( tGraphIndex &index, tHistory &history, ttOptimizer &optimizer, std::vector<unsigned char> &updated, tValues &gradient, tValues &weightUpdates, tValues &memoryGradient, tValues &memoryUpdates, tNeurotransmitter learningRate )
+			{
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				auto Mark = tParent::ttProfiler::tClock::now();
+#endif
+				tParent::_applyUpdates( index, optimizer, updated, gradient, weightUpdates, learningRate );
+
+				// The memory weights are numbered after the dendrites
+				optimizer.Step( memoryGradient.data(), memoryUpdates.data(), index.Weight.size(), memoryGradient.size(), learningRate );
+
+				// Regularized the same way as the dendrites (see tTrainer<>::_applyUpdates())
+				const bool Regularized = this->_regularized();
+				const tNeurotransmitter Decay = learningRate * this->WeightDecay;
+
+				for ( size_t n = 0; n < history.NumNeurons; ++n )
+				{
+					for ( size_t k = 0; k < MemorySize; ++k )
+					{
+						tNeurotransmitter &Weight = history.Neuron[ n ]->MemoryWeight[ k ];
+						const size_t m = (n * MemorySize) + k;
+
+						Weight += memoryUpdates[ m ] - (Decay * Weight);
+						memoryGradient[ m ] = (Regularized ? this->_penalty(Weight) : tNeurotransmitter());
+					}
+				}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				this->_countUpdates( memoryUpdates.data(), memoryUpdates.size() );
+				this->_EpochCounters.ApplyTime += tParent::_lap( Mark );
+#endif
+			}
+
+			// Updates the weights after every 'batchSize' windows (0 for the whole set at once)
+			bool _trainSequences( ttRecurrent &network, const ttTrainingSet &set, const ttTrainingSet *validation, tNeurotransmitter *networkError, size_t *numCycles, size_t batchSize )
+			{
+				if ( !network.UseBias )
+					throw std::runtime_error("Toolbox::NeuralNetwork::RecurrentTrainer::Train(): Network must use a bias.");
+
+				if ( Window == 0 )
+					throw std::runtime_error("Toolbox::NeuralNetwork::RecurrentTrainer::Train(): Window must be at least 1.");
+
+				size_t TrainingSetSize = set.Size();
+
+				if ( TrainingSetSize <= 0 )
+					throw std::runtime_error("Toolbox::NeuralNetwork::RecurrentTrainer::Train(): Training set is empty.");
+
+				tGraphIndex Index;
+				this->_indexNetwork( network, Index );
+
+				tHistory History;
+				_buildHistory( network, Index, History );
+
+				// Find where everything lives in the set, once
+				auto Binding = set.Bind( network );
+				tInputNeurons InputNeurons;
+				_bindInputs( network, Binding, InputNeurons );
+
+				for ( size_t o = 0; o < Index.NumOutputs; ++o )
+					Index.Neurons[ o ].Target = Binding.Output[ o ];
+
+				const size_t NumNeurons = Index.Neurons.size();
+				const size_t NumConnections = Index.Weight.size();
+				const size_t NumMemoryWeights = NumNeurons * MemorySize;
+
+				// Allocated once and reused for every window of every cycle
+				tValues Gradient( NumConnections ), WeightUpdates( NumConnections );
+				tValues MemoryGradient( NumMemoryWeights ), MemoryUpdates( NumMemoryWeights );
+				std::vector< unsigned char > Updated( NumNeurons, false );
+
+				auto CurOptimizer = this->_optimizer();
+				CurOptimizer->Reset( NumConnections + NumMemoryWeights );
+
+				// _applyUpdates() leaves each weight's penalty in its gradient for next time, so the first update needs them up front
+				this->_seedPenalties( Index, Gradient );
+
+				for ( size_t n = 0; n < NumNeurons && this->_regularized(); ++n )
+				{
+					for ( size_t k = 0; k < MemorySize; ++k )
+						MemoryGradient[ (n * MemorySize) + k ] = this->_penalty( History.Neuron[n]->MemoryWeight[k] );
+				}
+
+				if ( this->Schedule )
+					this->Schedule->Reset();
+
+				tNeurotransmitter LastError = std::numeric_limits< tNeurotransmitter >::infinity();
+				tNeurotransmitter BestError = LastError;
+				size_t BestCycle = 0;
+				tValues BestWeights;
+
+				tNeurotransmitter SetError = tNeurotransmitter();
+				bool Trained = false;
+
+				const size_t CurSequenceLength = (SequenceLength != 0 ? SequenceLength : TrainingSetSize);
+				const size_t NumSequences = (TrainingSetSize + CurSequenceLength - 1) / CurSequenceLength;
+
+				std::vector< size_t > Order( NumSequences );
+				std::mt19937 Random( this->Seed );
+
+				for ( size_t s = 0; s < NumSequences; ++s )
+					Order[ s ] = s;
+
+				unsigned int CurCycle = 0;
+				for ( ; this->MaxTrainingCycles != 0 && CurCycle < this->MaxTrainingCycles; ++CurCycle )
+				{
+					SetError = tNeurotransmitter();
+					CurOptimizer->NewCycle();
+
+					tNeurotransmitter CurLearningRate = (this->Schedule ? this->Schedule->Rate(this->LearningRate, CurCycle, this->MaxTrainingCycles, LastError) : this->LearningRate);
+
+					if ( this->Shuffle )
+						tParent::_shuffle( Order, Random );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+					double EpochStart = this->_startEpoch();
+#endif
+
+					size_t NumWindows = 0;
+
+					for ( size_t s = 0; s < NumSequences; ++s )
+					{
+						const size_t FirstRecord = Order[ s ] * CurSequenceLength;
+						const size_t Length = std::min( CurSequenceLength, TrainingSetSize - FirstRecord );
+
+						network.ClearMemory();
+
+						for ( size_t WindowStart = 0; WindowStart < Length; WindowStart += Window )
+						{
+							const size_t WindowEnd = std::min( WindowStart + Window, Length );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+							auto Mark = tParent::ttProfiler::tClock::now();
+#endif
+
+							for ( size_t Pass = WindowStart; Pass < WindowEnd; ++Pass )
+							{
+								auto Record = set.Record( FirstRecord + Pass );
+
+								for ( auto i = InputNeurons.begin(), i_end = InputNeurons.end(); i != i_end; ++i )
+									i->first->SetValue( Record.Input[i->second] );
+
+								network.Process( this->MaxProcessingCycles );
+								_record( History, Pass, Record.Output );
+							}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+							this->_EpochCounters.ForwardTime += tParent::_lap( Mark );
+#endif
+
+							SetError += _backpropagate( Index, History, WindowStart, WindowEnd, Gradient, MemoryGradient, Updated );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+							this->_EpochCounters.BackwardTime += tParent::_lap( Mark );
+#endif
+
+							if ( batchSize != 0 && ++NumWindows % batchSize == 0 )
+								_applyUpdates( Index, History, *CurOptimizer, Updated, Gradient, WeightUpdates, MemoryGradient, MemoryUpdates, CurLearningRate );
+						}
+					}
+
+					// Whatever is left of the last mini-batch
+					if ( batchSize != 0 && NumWindows % batchSize != 0 )
+						_applyUpdates( Index, History, *CurOptimizer, Updated, Gradient, WeightUpdates, MemoryGradient, MemoryUpdates, CurLearningRate );
+
+					if ( SetError <= this->AllowedError )
+					{
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						this->_endEpoch( EpochStart, CurCycle, TrainingSetSize, SetError, CurLearningRate );
+#endif
+						Trained = true;
+						break;
+					}
+
+					if ( batchSize == 0 )
+						_applyUpdates( Index, History, *CurOptimizer, Updated, Gradient, WeightUpdates, MemoryGradient, MemoryUpdates, CurLearningRate );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+					this->_endEpoch( EpochStart, CurCycle, TrainingSetSize, SetError, CurLearningRate );
+#endif
+
+					LastError = SetError;
+
+					if ( validation )
+						this->Validate( network, *validation, &LastError );
+
+					if ( LastError < BestError )
+					{
+						BestError = LastError;
+						BestCycle = CurCycle;
+
+						// Checkpoint the weights (dendrites, then memory) that did best on the validation set
+						if ( validation && this->RestoreBest )
+							_copyWeights( Index, History, BestWeights );
+					}
+					else if ( this->Patience != 0 && CurCycle - BestCycle >= this->Patience )
+						break;
+				}
+
+				if ( !Trained && !BestWeights.empty() )
+				{
+					for ( size_t d = 0; d < NumConnections; ++d )
+						*(Index.Weight[ d ]) = BestWeights[ d ];
+
+					for ( size_t n = 0; n < NumNeurons; ++n )
+					{
+						for ( size_t k = 0; k < MemorySize; ++k )
+							History.Neuron[ n ]->MemoryWeight[ k ] = BestWeights[ NumConnections + (n * MemorySize) + k ];
+					}
+				}
+
+				if ( numCycles )
+					*numCycles = CurCycle;
+
+				if ( networkError )
+					*networkError = SetError;
+
+				return Trained;
+			}
+
+			static void _copyWeights( const tGraphIndex &index, const tHistory &history, tValues &weights )
+			{
+				weights.clear();
+
+				for ( auto w = index.Weight.begin(), w_end = index.Weight.end(); w != w_end; ++w )
+					weights.push_back( **w );
+
+				for ( size_t n = 0; n < history.NumNeurons; ++n )
+					weights.insert( weights.end(), history.Neuron[n]->MemoryWeight.begin(), history.Neuron[n]->MemoryWeight.end() );
+			}
+		};
+
+		typedef tRecurrentTrainer<>		RecurrentTrainer;
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_RECURRENTTRAINER_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-namespaces --indent-cases --pad-oper
@@ -0,0 +1,208 @@
+#ifndef TOOLBOX_NEURALNETWORK_SCHEDULE_HPP
+#define TOOLBOX_NEURALNETWORK_SCHEDULE_HPP
+
+/*
+ * Toolbox/NeuralNetwork/Schedule.hpp
+ *
+ * Learning rate schedules -- Changing the learning rate as training goes on.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - The trainer asks its schedule for the learning rate at the start of each
+ *   training cycle, passing along the trainer's own LearningRate (the
+ *   starting point), the cycle number, and the error from the previous cycle
+ *   (the validation error when training with a validation set, otherwise the
+ *   training set's error).
+ *
+ * - tStepSchedule<> multiplies the rate by Factor every StepSize cycles.
+ *
+ * - tCosineSchedule<> eases the rate down to MinLearningRate along a cosine
+ *   curve over Period cycles (MaxTrainingCycles when Period is 0), then
+ *   starts over.
+ *
+ * - tPlateauSchedule<> multiplies the rate by Factor whenever the error
+ *   hasn't improved for Patience cycles, stopping at MinLearningRate.
+ *
+ ****************************************************************************
+	Toolbox::NeuralNetwork::Trainer MyTrainer;
+
+	// Halve the learning rate every 1000 cycles
+	MyTrainer.Schedule = std::make_shared< Toolbox::NeuralNetwork::StepSchedule >( 1000, 0.5 );
+
+	MyTrainer.Train( MyGanglion, MyTrainingSet );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <cmath>
+#include <limits>
+
+#include <Toolbox/NeuralNetwork/Neuron.hpp>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tSchedule
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+
+			TOOLBOX_POINTERS( tSchedule<tNeurotransmitter> )
+
+		public:
+			tSchedule()
+			{
+			}
+
+			virtual ~tSchedule()
+			{
+			}
+
+			// Called once, at the start of training
+			virtual void Reset()
+			{
+			}
+
+			// 'error' is the previous cycle's error (infinity for the first cycle)
+			virtual tNeurotransmitter Rate( tNeurotransmitter learningRate, size_t cycle, size_t maxCycles, tNeurotransmitter error ) = 0;
+		};
+
+		typedef tSchedule<>			Schedule;
+
+
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tStepSchedule : public tSchedule< _tNeurotransmitter >
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+
+			TOOLBOX_POINTERS( tStepSchedule<tNeurotransmitter> )
+
+		public:
+			size_t					StepSize;
+			tNeurotransmitter		Factor;
+
+		public:
+			tStepSchedule( size_t stepSize = 1000, tNeurotransmitter factor = tNeurotransmitter(0.5) ):
+				StepSize( stepSize ),
+				Factor( factor )
+			{
+			}
+
+			virtual tNeurotransmitter Rate( tNeurotransmitter learningRate, size_t cycle, size_t maxCycles, tNeurotransmitter error )
+			{
+				if ( StepSize == 0 )
+					return learningRate;
+
+				return learningRate * std::pow( Factor, tNeurotransmitter(cycle / StepSize) );
+			}
+		};
+
+		typedef tStepSchedule<>		StepSchedule;
+
+
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tCosineSchedule : public tSchedule< _tNeurotransmitter >
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+
+			TOOLBOX_POINTERS( tCosineSchedule<tNeurotransmitter> )
+
+		public:
+			size_t					Period;				// 0 uses the trainer's MaxTrainingCycles
+			tNeurotransmitter		MinLearningRate;
+
+		public:
+			tCosineSchedule( size_t period = 0, tNeurotransmitter minLearningRate = tNeurotransmitter() ):
+				Period( period ),
+				MinLearningRate( minLearningRate )
+			{
+			}
+
+			virtual tNeurotransmitter Rate( tNeurotransmitter learningRate, size_t cycle, size_t maxCycles, tNeurotransmitter error )
+			{
+				size_t CurPeriod = (Period != 0 ? Period : maxCycles);
+
+				if ( CurPeriod == 0 )
+					return learningRate;
+
+				const tNeurotransmitter Pi = tNeurotransmitter( 3.14159265358979323846 );
+				tNeurotransmitter Progress = tNeurotransmitter(cycle % CurPeriod) / tNeurotransmitter(CurPeriod);
+
+				return MinLearningRate + ((learningRate - MinLearningRate) * tNeurotransmitter(0.5) * (tNeurotransmitter(1) + std::cos(Pi * Progress)));
+			}
+		};
+
+		typedef tCosineSchedule<>	CosineSchedule;
+
+
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tPlateauSchedule : public tSchedule< _tNeurotransmitter >
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+
+			TOOLBOX_POINTERS( tPlateauSchedule<tNeurotransmitter> )
+
+		public:
+			size_t					Patience;			// Cycles without improvement before lowering the rate
+			tNeurotransmitter		Factor;
+			tNeurotransmitter		MinLearningRate;
+
+		public:
+			tPlateauSchedule( size_t patience = 100, tNeurotransmitter factor = tNeurotransmitter(0.5), tNeurotransmitter minLearningRate = tNeurotransmitter() ):
+				Patience( patience ),
+				Factor( factor ),
+				MinLearningRate( minLearningRate )
+			{
+				Reset();
+			}
+
+			virtual void Reset()
+			{
+				_Scale = tNeurotransmitter( 1 );
+				_BestError = std::numeric_limits< tNeurotransmitter >::infinity();
+				_Waiting = 0;
+			}
+
+			virtual tNeurotransmitter Rate( tNeurotransmitter learningRate, size_t cycle, size_t maxCycles, tNeurotransmitter error )
+			{
+				if ( error < _BestError )
+				{
+					_BestError = error;
+					_Waiting = 0;
+				}
+				else if ( cycle > 0 && ++_Waiting >= Patience )
+				{
+					_Scale *= Factor;
+					_Waiting = 0;
+				}
+
+				tNeurotransmitter CurRate = learningRate * _Scale;
+				return (CurRate < MinLearningRate ? MinLearningRate : CurRate);
+			}
+
+		protected:
+			tNeurotransmitter		_Scale;				// What we've reduced the rate to so far
+			tNeurotransmitter		_BestError;
+			size_t					_Waiting;			// Cycles since the error last improved
+		};
+
+		typedef tPlateauSchedule<>	PlateauSchedule;
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_SCHEDULE_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
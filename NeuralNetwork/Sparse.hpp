@@ -0,0 +1,490 @@
+#ifndef TOOLBOX_NEURALNETWORK_SPARSE_HPP
+#define TOOLBOX_NEURALNETWORK_SPARSE_HPP
+
+/*
+ * Toolbox/NeuralNetwork/Sparse.hpp
+ *
+ * A flattened, sparse (CSR) execution engine for ganglia of any shape.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - A sparse ganglion is a frozen snapshot of a tGanglion<> with every
+ *   neuron numbered and every connection stored in flat arrays (compressed
+ *   sparse rows): one row of (source neuron, weight) pairs per neuron, and
+ *   one row of axon neurons per neuron.  Processing it walks those arrays
+ *   instead of the dendrite maps, with no weak_ptr locking along the way.
+ *
+ * - Unlike tCompiledGanglion<> (Compiled.hpp), any topology can be flattened
+ *   this way -- skip connections, recurrent connections, neurons connected to
+ *   themselves, and networks with only a few of their possible connections.
+ *   Only the connections that exist take up any room.
+ *
+ * - Neurons are numbered the same way as in a network file: the BiasNeuron
+ *   (0), the inputs (in label order), each hidden layer (in index order),
+ *   then the outputs (in label order).  Each neuron's dendrites are sorted by
+ *   the number of the neuron on the other end.
+ *
+ * - Processing follows the same rules as tGanglion<>::Process() (the same
+ *   processing order and recurrent groups, thresholds, processing cycle
+ *   limits, and which neurons count as activated).  Only the order each
+ *   neuron's weighted inputs are summed in differs, so results match to
+ *   within floating point rounding.  The nucleus' Activation() is used, but
+ *   not its Accumulator(), so neurons with custom accumulators should be run
+ *   as a regular ganglion.
+ *
+ * - Recurrent neurons (see Recurrent.hpp) can't be flattened -- There's
+ *   nowhere to keep their memory, so Compile() throws for them.  Use
+ *   tRecurrent<>::ProcessSequence() instead.
+ *
+ * - SoftmaxOutput works the same as in tGanglion<>: after each pass, the
+ *   outputs' weighted sums are gathered again and put through the softmax
+ *   as a whole, and GetOutput() returns the result.  The output neurons
+ *   keep their activated values in Value (and pass those on to anything
+ *   they are connected to).
+ *
+ * - The neuron graph remains the editable source of truth.  AddDendrite(),
+ *   RemoveDendrite() and friends work on the ganglion as always, and changes
+ *   show up here once it is compiled again.  Export() copies the weights
+ *   back into the ganglion.
+ *
+ ****************************************************************************
+	Ganglion MyGanglion;
+	// ... Create, connect and train the network as usual ...
+
+	// Flatten the network
+	Ganglion::ttSparseGanglion Sparse = MyGanglion.CompileSparse();
+
+	// Then use it just like the ganglion itself
+	Sparse.SetInput( "Input 1", 1.0 );
+	Sparse.SetInput( "Input 2", 0.0 );
+	Sparse.Process();
+
+	double Output = Sparse.GetOutput( "Output" );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Toolbox/NeuralNetwork/Compiled.hpp>
+#include <Toolbox/NeuralNetwork/Neuron.hpp>
+#include <Toolbox/NeuralNetwork/ProcessingOrder.hpp>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		template <typename _tNeuron = Neuron>
+		class tSparseGanglion
+		{
+		public:
+			typedef _tNeuron									ttNeuron;
+			typedef typename ttNeuron::tNeurotransmitter		tNeurotransmitter;
+			typedef tSparseGanglion< ttNeuron >					ttSparseGanglion;
+
+			TOOLBOX_POINTERS( ttSparseGanglion )
+
+			typedef uint32_t									tIndex;
+			typedef std::vector< tNeurotransmitter >			tValues;
+			typedef std::vector< tIndex >						tIndices;
+			typedef std::vector< unsigned char >				tFlags;
+
+		public:
+			std::vector< std::string >	InputLabels;		// In the same order as the ganglion's Input map
+			std::vector< std::string >	OutputLabels;		// In the same order as the ganglion's Output map
+
+			// Per neuron, plus one past the end -- Index into Source/Weight, and Axon
+			tIndices					FirstDendrite;
+			tIndices					FirstAxon;
+
+			tIndices					Source;				// Per dendrite -- The neuron on the other end
+			tValues						Weight;				// Per dendrite
+			tIndices					Axon;				// Per axon -- In the same order as the neuron's Axons list
+			tValues						Threshold;			// Per neuron
+
+			// Per neuron -- Everything that changes while processing
+			tValues						Value;
+			tValues						PrevValue;
+			tFlags						Processed;
+			tFlags						Activated;
+
+			bool						UseBias;
+			bool						SoftmaxOutput;		// GetOutput() returns a softmax over the outputs' sums (see tGanglion<>::SoftmaxOutput)
+
+		public:
+			tSparseGanglion():
+				UseBias( true ),
+				SoftmaxOutput( false )
+			{
+			}
+
+			template <typename tGanglion>
+			tSparseGanglion( const tGanglion &network ):
+				UseBias( true ),
+				SoftmaxOutput( false )
+			{
+				Compile( network );
+			}
+
+			virtual ~tSparseGanglion()
+			{
+			}
+
+			// Flattens the network -- Can be called again at any time to pick up changes to the network
+			template <typename tGanglion>
+			void Compile( const tGanglion &network )
+			{
+				InputLabels.clear();
+				OutputLabels.clear();
+				FirstDendrite.assign( 1, 0 );
+				FirstAxon.assign( 1, 0 );
+				Source.clear();
+				Weight.clear();
+				Axon.clear();
+				Threshold.clear();
+				Value.clear();
+				PrevValue.clear();
+				Processed.clear();
+				Activated.clear();
+
+				if ( !network.BiasNeuron )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tSparseGanglion<>::Compile(): Network has no bias neuron." );
+
+				if ( tHasMemory<ttNeuron>::value )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tSparseGanglion<>::Compile(): Recurrent networks can't be compiled (their memory would be left out)." );
+
+				UseBias = network.UseBias;
+				SoftmaxOutput = network.SoftmaxOutput;
+
+				if ( SoftmaxOutput && !UseBias )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tSparseGanglion<>::Compile(): SoftmaxOutput needs a network using a bias." );
+
+				tNeurons Neurons;
+				Neurons.push_back( network.BiasNeuron );
+
+				for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i )
+				{
+					InputLabels.push_back( i->first );
+					Neurons.push_back( i->second );
+				}
+
+				for ( auto l = network.Hidden.begin(), l_end = network.Hidden.end(); l != l_end; ++l )
+				{
+					for ( auto h = l->second.begin(), h_end = l->second.end(); h != h_end; ++h )
+						Neurons.push_back( h->second );
+				}
+
+				for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
+				{
+					OutputLabels.push_back( o->first );
+					Neurons.push_back( o->second );
+				}
+
+				std::map< const _Neuron<tNeurotransmitter> *, tIndex > Numbers;
+
+				for ( size_t n = 0, n_end = Neurons.size(); n < n_end; ++n )
+					Numbers[ Neurons[n].get() ] = tIndex( n );
+
+				std::vector< std::pair<tIndex, tNeurotransmitter> > Dendrites;
+
+				for ( auto n = Neurons.begin(), n_end = Neurons.end(); n != n_end; ++n )
+				{
+					Dendrites.clear();
+
+					for ( auto d = (*n)->Dendrites.begin(), d_end = (*n)->Dendrites.end(); d != d_end; ++d )
+					{
+						auto Dendrite = (d->first).lock();
+
+						if ( Dendrite )
+							Dendrites.push_back( std::make_pair(_number(Numbers, Dendrite.get()), d->second) );
+					}
+
+					std::sort( Dendrites.begin(), Dendrites.end() );
+
+					for ( auto d = Dendrites.begin(), d_end = Dendrites.end(); d != d_end; ++d )
+					{
+						Source.push_back( d->first );
+						Weight.push_back( d->second );
+					}
+
+					for ( auto a = (*n)->Axons.begin(), a_end = (*n)->Axons.end(); a != a_end; ++a )
+					{
+						auto CurAxon = a->lock();
+
+						if ( CurAxon )
+							Axon.push_back( _number(Numbers, CurAxon.get()) );
+					}
+
+					FirstDendrite.push_back( tIndex(Source.size()) );
+					FirstAxon.push_back( tIndex(Axon.size()) );
+
+					// Start off from wherever the network currently is
+					Threshold.push_back( (*n)->Threshold );
+					Value.push_back( (*n)->Value() );
+					PrevValue.push_back( (*n)->PrevValue() );
+					Processed.push_back( (*n)->Processed() );
+					Activated.push_back( (*n)->Activated() );
+				}
+
+				std::vector< size_t > Inputs;
+
+				for ( size_t i = 0, i_end = InputLabels.size(); i < i_end; ++i )
+					Inputs.push_back( 1 + i );
+
+				_Order.Build( FirstAxon, Axon, Inputs );
+				_Pending.assign( Neurons.size(), 0 );
+			}
+
+			// Copies the weights back into the network they were compiled from
+			template <typename tGanglion>
+			void Export( tGanglion &network ) const
+			{
+				tSparseGanglion Current( network );
+
+				if ( Current.FirstDendrite != FirstDendrite || Current.Source != Source )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tSparseGanglion<>::Export(): Network does not match." );
+
+				// Same numbering, so each weight can be found by its neuron's position and the neuron on the other end
+				tNeurons Neurons;
+				Neurons.push_back( network.BiasNeuron );
+
+				for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i )
+					Neurons.push_back( i->second );
+
+				for ( auto l = network.Hidden.begin(), l_end = network.Hidden.end(); l != l_end; ++l )
+				{
+					for ( auto h = l->second.begin(), h_end = l->second.end(); h != h_end; ++h )
+						Neurons.push_back( h->second );
+				}
+
+				for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
+					Neurons.push_back( o->second );
+
+				for ( size_t n = 0, n_end = Neurons.size(); n < n_end; ++n )
+				{
+					for ( tIndex d = FirstDendrite[n], d_end = FirstDendrite[n + 1]; d < d_end; ++d )
+						Neurons[ n ]->Dendrites[ Neurons[Source[d]] ] = Weight[ d ];
+				}
+
+				network.Invalidate();
+			}
+
+			size_t NumNeurons() const
+			{
+				return Threshold.size();
+			}
+
+			size_t NumConnections() const
+			{
+				return Source.size();
+			}
+
+			size_t NumInputs() const
+			{
+				return InputLabels.size();
+			}
+
+			size_t NumOutputs() const
+			{
+				return OutputLabels.size();
+			}
+
+			void SetInput( const std::string &label, tNeurotransmitter value = tNeurotransmitter() )
+			{
+				for ( size_t i = 0, i_end = InputLabels.size(); i < i_end; ++i )
+				{
+					if ( InputLabels[i] == label )
+						return SetInput( i, value );
+				}
+
+				throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tSparseGanglion<>::SetInput(): Input '") + label + std::string("' not found.") );
+			}
+
+			// Same as the neuron's SetValue()
+			void SetInput( size_t index, tNeurotransmitter value = tNeurotransmitter() )
+			{
+				if ( index >= InputLabels.size() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tSparseGanglion<>::SetInput(): Index out of range." );
+
+				Value[ 1 + index ] = value;
+				PrevValue[ 1 + index ] = value;
+				Processed[ 1 + index ] = false;
+			}
+
+			tNeurotransmitter GetOutput( const std::string &label ) const
+			{
+				for ( size_t o = 0, o_end = OutputLabels.size(); o < o_end; ++o )
+				{
+					if ( OutputLabels[o] == label )
+						return GetOutput( o );
+				}
+
+				throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tSparseGanglion<>::GetOutput(): Output '") + label + std::string("' not found.") );
+			}
+
+			tNeurotransmitter GetOutput( size_t index ) const
+			{
+				if ( index >= OutputLabels.size() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tSparseGanglion<>::GetOutput(): Index out of range." );
+
+				if ( SoftmaxOutput && _Softmax.size() == OutputLabels.size() )
+					return _Softmax[ index ];
+
+				return Value[ NumNeurons() - OutputLabels.size() + index ];
+			}
+
+			// Same rules (and order) as tGanglion<>::Process()
+			virtual void Process( size_t maxProcessingCycles = Default::MaxProcessingCycles )
+			{
+				std::fill( _Pending.begin(), _Pending.end(), 0 );
+
+				// Start with the input neurons
+				for ( tIndex i = 1, i_end = tIndex(1 + InputLabels.size()); i < i_end; ++i )
+				{
+					_needsProcessing( i );
+					_Pending[ i ] = 1;
+				}
+
+				for ( auto g = _Order.Groups.begin(), g_end = _Order.Groups.end(); g != g_end; ++g )
+				{
+					size_t CurCycle = g->Level;
+					bool Again = false;
+
+					// Recurrent groups go around again whenever a neuron fires back into one we've already been through
+					do
+					{
+						if ( maxProcessingCycles != 0 && CurCycle++ >= maxProcessingCycles )
+							break;
+
+						Again = false;
+
+						for ( size_t p = g->First; p < g->Last; ++p )
+						{
+							tIndex n = tIndex( _Order.Order[p] );
+
+							if ( !_Pending[n] )
+								continue;
+
+							_Pending[ n ] = 0;
+
+							// If neurons fire, their axons need processing
+							if ( _process(n) )
+							{
+								for ( tIndex a = FirstAxon[n], a_end = FirstAxon[n + 1]; a < a_end; ++a )
+								{
+									size_t CurAxon = _Order.Position[ Axon[a] ];
+
+									_needsProcessing( Axon[a] );
+									_Pending[ Axon[a] ] = 1;
+
+									if ( CurAxon >= g->First && CurAxon <= p )
+										Again = true;
+								}
+							}
+						}
+					}
+					while ( Again );
+				}
+
+				if ( SoftmaxOutput )
+				{
+					const tIndex FirstOutput = tIndex( NumNeurons() - OutputLabels.size() );
+					_Softmax.resize( OutputLabels.size() );
+
+					for ( size_t o = 0, o_end = OutputLabels.size(); o < o_end; ++o )
+						_Softmax[ o ] = _sum( tIndex(FirstOutput + o) );
+
+					Activation::Softmax( _Softmax.data(), _Softmax.data(), _Softmax.size() );
+				}
+			}
+
+		protected:
+			typedef std::vector< typename _Neuron<tNeurotransmitter>::Ptr >	tNeurons;
+
+		protected:
+			ProcessingOrder				_Order;
+			tFlags						_Pending;			// Per neuron -- Whether it needs processing during this pass
+			tValues						_Softmax;			// Per output -- The softmax outputs from the last pass
+
+		protected:
+			static tIndex _number( const std::map<const _Neuron<tNeurotransmitter> *, tIndex> &numbers, const _Neuron<tNeurotransmitter> *neuron )
+			{
+				auto Number = numbers.find( neuron );
+
+				if ( Number == numbers.end() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tSparseGanglion<>::Compile(): Network is connected to neurons outside of itself." );
+
+				return Number->second;
+			}
+
+			void _needsProcessing( tIndex neuron )
+			{
+				Processed[ neuron ] = false;
+				Activated[ neuron ] = false;
+			}
+
+			// The default accumulator
+			tNeurotransmitter _sum( tIndex neuron ) const
+			{
+				tNeurotransmitter Sum = tNeurotransmitter();
+
+				for ( tIndex d = FirstDendrite[neuron], d_end = FirstDendrite[neuron + 1]; d < d_end; ++d )
+				{
+					const tIndex CurSource = Source[ d ];
+
+					// Inputs and the bias always count, everything else only if it's activated
+					if ( Activated[CurSource] || FirstDendrite[CurSource] == FirstDendrite[CurSource + 1] )
+						Sum += (CurSource == neuron ? PrevValue[CurSource] : Value[CurSource]) * Weight[ d ];
+				}
+
+				return Sum;
+			}
+
+			// The same as tNeuron<>::Process() with the default accumulator -- Returns 'true' if the neuron fires
+			bool _process( tIndex neuron )
+			{
+				if ( Processed[neuron] )
+					return false;
+
+				Processed[ neuron ] = true;
+				PrevValue[ neuron ] = Value[ neuron ];
+
+				const tIndex First = FirstDendrite[ neuron ];
+				const tIndex Last = FirstDendrite[ neuron + 1 ];
+
+				// If we have no dendrites, assume we're an input/bias neuron and activate 100% of the time
+				if ( First == Last )
+				{
+					Activated[ neuron ] = true;
+					return true;
+				}
+
+				Value[ neuron ] = ttNeuron::Activate( _sum(neuron) );
+
+				// If we're not using a threshold (bias instead), or if we exceed the set threshold
+				if ( UseBias || Value[neuron] >= Threshold[neuron] )
+					Activated[ neuron ] = true;
+
+				return Activated[ neuron ];
+			}
+		};
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_SPARSE_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
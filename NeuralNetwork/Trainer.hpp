@@ -19,12 +19,136 @@
  *
  * - TrainingData provides an easy interface to work with a single data point
  *   from a TrainingSet.
+ *
+ * - A TrainingSet stores its inputs and outputs as two row-major matrices
+ *   (one row per record), with the columns sorted by label -- the same order
+ *   as a ganglion's Input and Output maps.  Record() returns pointers
+ *   straight into those matrices without copying anything, and Bind()
+ *   matches the columns up with a network's inputs/outputs.  GetRecord()
+ *   still builds a labeled TrainingData copy for convenience.
+ *
+ * - Save() writes a TrainingSet out in a compact binary format, and Open()
+ *   memory-maps one back in (see TrainingFile.hpp).  When the file's value
+ *   type matches ours, the set uses the mapped data directly -- nothing is
+ *   read until it is used, and the pages are shared with any other process
+ *   using the same file.  Changing an opened set (adding records, etc.)
+ *   copies it into memory first.
+ *
+ * - There are three ways to train: Train() updates the weights after every
+ *   record (incremental), BatchTrain() after the whole set, and
+ *   MiniBatchTrain() after every BatchSize records.  Setting Shuffle visits
+ *   the records in a new random order each training cycle, starting from
+ *   Seed, so a run can always be repeated exactly.
+ *
+ * - The weight updates themselves come from an Optimizer (see Optimizer.hpp).
+ *   Leaving it unset uses plain gradient descent with the original
+ *   trainer's momentum (the whole of the previous update, within a cycle).
+ *
+ * - Momentum has no effect.  The original trainer never used it either, and
+ *   it is only kept so existing code still compiles.  For a different
+ *   momentum, set an Optimizer (std::make_shared<SGD>( 0.9 ), for example).
+ *
+ * - Setting Threads (above zero) trains a compiled copy of the network (see
+ *   Compiled.hpp) instead of the network itself, and copies the trained
+ *   weights back when finished.  Each batch of records is split into
+ *   contiguous chunks, one per thread, and each thread runs its own forward
+ *   and backward passes (with its own activations and gradients) against the
+ *   shared weights.  The chunk gradients are then added together in chunk
+ *   order, so training runs the same way every time for a given number of
+ *   threads.
+ *
+ * - Incremental training updates the weights after every record, so there is
+ *   only ever one record to work on at a time.  Mini-batch and batch
+ *   training are where the extra threads pay off.
+ *
+ * - The threaded trainer needs a layered network using a bias (networks
+ *   using thresholds carry state from one record to the next), and a
+ *   MaxProcessingCycles large enough to reach the outputs.  Anything else
+ *   (recurrent networks included, since the compiled copy has no memory) is
+ *   trained the original way, on the calling thread.
+ *
+ * - Passing a separate validation set to Train() (or BatchTrain() or
+ *   MiniBatchTrain()) checks the network against it after every training
+ *   cycle, and remembers the weights that did best on it.  If training ends
+ *   without reaching AllowedError, those best weights are put back in place
+ *   (unless RestoreBest is turned off).
+ *
+ * - Setting Patience (above zero) stops training early once the error hasn't
+ *   improved for that many cycles -- The validation error when there is a
+ *   validation set, otherwise the training set's own error.
+ *
+ * - A Schedule (see Schedule.hpp) changes the learning rate from one training
+ *   cycle to the next.  Leaving it unset uses LearningRate throughout.
+ *
+ * - Dropout leaves out each hidden neuron with that chance, for each record
+ *   of each training cycle (the rest are scaled up to make up for it, so
+ *   nothing needs changing once training is done).  The neurons left out are
+ *   picked from Seed, the cycle and the record, so a run can be repeated
+ *   exactly with any number of threads.  Dropout needs the compiled trainer,
+ *   so setting it trains through a compiled copy of the network even
+ *   without Threads (and only works on networks the threaded trainer can
+ *   handle).
+ *
+ * - L1 and L2 add the usual penalties on the size of the weights to their
+ *   gradients, and WeightDecay shrinks each weight by LearningRate *
+ *   WeightDecay of itself with every update, apart from whatever the
+ *   Optimizer does (decoupled weight decay, as in AdamW).  None of them
+ *   touch the bias weights.  All three are worked into the same loop that
+ *   applies the Optimizer's updates -- The penalty for the next update is
+ *   worked out as each weight is changed, so they never add another pass
+ *   over the weights.
+ *
+ * - Networks with SoftmaxOutput (see Ganglion.hpp) are trained against
+ *   cross-entropy rather than CalculateError() -- Each record's error is the
+ *   sum of -target * log( output ) over the outputs, so the targets should
+ *   add up to 1 (one 1 and the rest 0 for picking a class), and AllowedError
+ *   is measured the same way.  The softmax and the cross-entropy are
+ *   differentiated together, which leaves just (output - target) for each
+ *   output's sum: no activation derivative to flatten out the gradient, so
+ *   classifiers train in far fewer cycles than with sigmoid outputs and the
+ *   squared error.  Outputs the set has no column for are aiming for 0.
+ *
+ * - With TOOLBOX_NEURALNETWORK_PROFILE defined, every training cycle reports
+ *   to Profiler (when set) -- The error, learning rate, time spent going
+ *   forward, backward and applying updates, and the size of the updates.
+ *   See Profile.hpp.
+ *
  ****************************************************************************
+	Trainer MyTrainer;
+	MyTrainer.Threads = 8;
+
+	MyTrainer.BatchSize = 64;
+	MyTrainer.Shuffle = true;
+
+	// Same interface (and results, give or take rounding) as without threads
+	MyTrainer.MiniBatchTrain( MyGanglion, MyTrainingSet, &Error, &Cycles );
+
+	// Stop once the validation set hasn't improved in 500 cycles, keeping the best weights seen
+	MyTrainer.Patience = 500;
+	MyTrainer.Schedule = std::make_shared< Toolbox::NeuralNetwork::CosineSchedule >();
+
+	MyTrainer.Train( MyGanglion, MyTrainingSet, MyValidationSet, &Error, &Cycles );
+
+	// Small networks that overfit
+	MyTrainer.Dropout = 0.2;
+	MyTrainer.WeightDecay = 0.01;
 
  ****************************************************************************/
 /****************************************************************************/
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
 #include <Toolbox/NeuralNetwork/Ganglion.hpp>
+#include <Toolbox/NeuralNetwork/MappedFile.hpp>
+#include <Toolbox/NeuralNetwork/Optimizer.hpp>
+#include <Toolbox/NeuralNetwork/Schedule.hpp>
+#include <Toolbox/NeuralNetwork/TrainingFile.hpp>
+#include <Toolbox/NeuralNetwork/WorkerPool.hpp>
 
 
 namespace Toolbox
@@ -37,6 +161,16 @@ namespace Toolbox
 			const double Momentum			= 0.2;				// The learning momentum for the network (Should be -gt 0 && -lt 1)
 			const double AllowedError		= 0.001;			// The allowed margin of error (0.10 = 10%, 0.001 = 0.1%)
 			const size_t MaxTrainingCycles	= 100000;			// How many training cycles to run through before giving up
+			const size_t TrainingThreads	= 0;				// How many threads to train with (0 trains the network directly, without compiling it)
+			const size_t BatchSize			= 32;				// How many records to see between weight updates when mini-batch training
+			const bool	 Shuffle			= false;			// Whether to visit the records in a different (random) order each training cycle
+			const unsigned int Seed			= 5489;				// Seeds the shuffling, so training can be repeated exactly
+			const size_t Patience			= 0;				// How many cycles without improvement to allow before stopping early (0 never stops early)
+			const bool	 RestoreBest		= true;				// Whether to go back to the best weights seen on the validation set when training stops short
+			const double Dropout			= 0.0;				// The chance of leaving out each hidden neuron for a record (0 never does)
+			const double L1					= 0.0;				// Penalties on the size of the weights (0 for none)
+			const double L2					= 0.0;
+			const double WeightDecay		= 0.0;				// How much of itself each weight loses with each update, times the learning rate
 
 			// Different activation functions define default ON/OFF values
 			namespace OFF
@@ -83,7 +217,8 @@ namespace Toolbox
 			}
 		};
 
-		typedef tTrainingData<>		TrainingData;
+		typedef tTrainingData<>			TrainingData;
+		typedef tTrainingData< float >	FloatTrainingData;
 
 
 
@@ -95,15 +230,40 @@ namespace Toolbox
 			typedef typename ttGanglion::tNeurotransmitter	tNeurotransmitter;
 			typedef tTrainingData< tNeurotransmitter >		ttTrainingData;
 			typedef tTrainingSet< ttGanglion >				ttTrainingSet;
+			typedef std::vector< tNeurotransmitter >		tValues;
+			typedef std::vector< std::string >				tLabels;
+
+			TOOLBOX_POINTERS( ttTrainingSet )
+
+			static constexpr size_t							NoColumn = size_t(-1);
 
-			TOOLBOX_POINTERS( tTrainingData<ttGanglion> )
+			// A single record, straight out of the set -- Columns are in label order, and the pointers are only good until the set is changed
+			struct tRecord
+			{
+				const tNeurotransmitter		*Input;
+				const tNeurotransmitter		*Output;
+			};
+
+			// Which of our columns feeds each of a network's inputs/outputs (NoColumn if we don't have it)
+			struct tBinding
+			{
+				std::vector< size_t >		Input;
+				std::vector< size_t >		Output;
+				bool						Direct;		// Our columns are exactly the network's, in the same order, so records can be used as-is
+			};
 
 		public:
-			tTrainingSet()
+			tTrainingSet():
+				_Size( 0 ),
+				_MappedInput( NULL ),
+				_MappedOutput( NULL )
 			{
 			}
 
-			tTrainingSet( const ttGanglion &copyIO )
+			tTrainingSet( const ttGanglion &copyIO ):
+				_Size( 0 ),
+				_MappedInput( NULL ),
+				_MappedOutput( NULL )
 			{
 				CopyIOFrom( copyIO );
 			}
@@ -114,18 +274,28 @@ namespace Toolbox
 
 			size_t Size() const
 			{
-				if ( _Inputs.empty() )
+				if ( _InputLabels.empty() )
 					return 0;
 
-				auto SizeCheck = _Inputs.begin();	// Should be valid if we're not empty
-
-				return SizeCheck->second.size();
+				return _Size;
 			}
 	
 			void Clear()
 			{
-				_Inputs.clear();
-				_Outputs.clear();
+				_Mapping.reset();
+				_InputLabels.clear();
+				_OutputLabels.clear();
+				_InputData.clear();
+				_OutputData.clear();
+				_Size = 0;
+			}
+
+			// Room for this many records without reallocating
+			void Reserve( size_t numRecords )
+			{
+				_ownData();
+				_InputData.reserve( numRecords * _InputLabels.size() );
+				_OutputData.reserve( numRecords * _OutputLabels.size() );
 			}
 
 			// Add inputs/outputs manually...
@@ -134,7 +304,7 @@ namespace Toolbox
 				if ( input.empty() )
 					throw std::runtime_error( "Toolbox::NeuralNetwork::tTrainer<>::AddInput(): No input name provided." );
 
-				_Inputs[ input ] = std::vector<tNeurotransmitter>();
+				_addColumn( _InputLabels, _InputData, input );
 			}
 
 			void AddOutput( const std::string &output )
@@ -142,47 +312,89 @@ namespace Toolbox
 				if ( output.empty() )
 					throw std::runtime_error( "Toolbox::NeuralNetwork::tTrainer<>::AddOutput(): No output name provided." );
 
-				_Outputs[ output ] = std::vector<tNeurotransmitter>();
+				_addColumn( _OutputLabels, _OutputData, output );
 			}
 
 			// ...Or add them all at once by copying from a similar source
 			void CopyIOFrom( const ttTrainingData &data )
 			{
 				for ( auto i = data.Input.begin(), i_end = data.Input.end(); i != i_end; ++i )
-					_Inputs[ i->first ] = std::vector<tNeurotransmitter>();
+					_addColumn( _InputLabels, _InputData, i->first );
 
 				for ( auto o = data.Output.begin(), o_end = data.Output.end(); o != o_end; ++o )
-					_Outputs[ o->first ] = std::vector<tNeurotransmitter>();
+					_addColumn( _OutputLabels, _OutputData, o->first );
 			}
 
 			void CopyIOFrom( const ttTrainingSet &set )
 			{
-				for ( auto i = set._Inputs.begin(), i_end = set._Inputs.end(); i != i_end; ++i )
-					_Inputs[ i->first ] = std::vector<tNeurotransmitter>();
+				for ( auto i = set._InputLabels.begin(), i_end = set._InputLabels.end(); i != i_end; ++i )
+					_addColumn( _InputLabels, _InputData, *i );
 
-				for ( auto o = set._Outputs.begin(), o_end = set._Outputs.end(); o != o_end; ++o )
-					_Outputs[ o->first ] = std::vector<tNeurotransmitter>();
+				for ( auto o = set._OutputLabels.begin(), o_end = set._OutputLabels.end(); o != o_end; ++o )
+					_addColumn( _OutputLabels, _OutputData, *o );
 			}
 
 			void CopyIOFrom( const ttGanglion &network )
 			{
 				for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i )
-					_Inputs[ i->first ] = std::vector<tNeurotransmitter>();
+					_addColumn( _InputLabels, _InputData, i->first );
 
 				for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
-					_Outputs[ o->first ] = std::vector<tNeurotransmitter>();
+					_addColumn( _OutputLabels, _OutputData, o->first );
+			}
+
+			size_t NumInputs() const
+			{
+				return _InputLabels.size();
+			}
+
+			size_t NumOutputs() const
+			{
+				return _OutputLabels.size();
+			}
+
+			// Column names, in column order
+			const tLabels &InputLabels() const
+			{
+				return _InputLabels;
+			}
+
+			const tLabels &OutputLabels() const
+			{
+				return _OutputLabels;
+			}
+
+			// The raw data -- Row-major, Size() x NumInputs() (or NumOutputs())
+			const tNeurotransmitter *InputData() const
+			{
+				return _Mapping ? _MappedInput : _InputData.data();
+			}
+
+			const tNeurotransmitter *OutputData() const
+			{
+				return _Mapping ? _MappedOutput : _OutputData.data();
+			}
+
+			// Once data has been added, we can get individual records with this (without copying anything)
+			tRecord Record( size_t index ) const
+			{
+				tRecord ReturnRecord;
+				ReturnRecord.Input = InputData() + (index * _InputLabels.size());
+				ReturnRecord.Output = OutputData() + (index * _OutputLabels.size());
+				return ReturnRecord;
 			}
 
-			// Once data has been added, we can get individual records with this
+			// ...Or as a (slower) labeled copy
 			ttTrainingData GetRecord( size_t index ) const
 			{
 				ttTrainingData ReturnData;
+				tRecord CurRecord = Record( index );
 
-				for ( auto i = _Inputs.begin(), i_end = _Inputs.end(); i != i_end; ++i )
-					ReturnData.Input[ i->first ] = i->second[ index ];
+				for ( size_t i = 0, i_end = _InputLabels.size(); i < i_end; ++i )
+					ReturnData.Input[ _InputLabels[i] ] = CurRecord.Input[ i ];
 
-				for ( auto o = _Outputs.begin(), o_end = _Outputs.end(); o != o_end; ++o )
-					ReturnData.Output[ o->first ] = o->second[ index ];
+				for ( size_t o = 0, o_end = _OutputLabels.size(); o < o_end; ++o )
+					ReturnData.Output[ _OutputLabels[o] ] = CurRecord.Output[ o ];
 
 				return ReturnData;
 			}
@@ -190,33 +402,240 @@ namespace Toolbox
 			// Essentially the push_back() of this class
 			void AddRecord( ttTrainingData &data )
 			{
-				for ( auto i = _Inputs.begin(), i_end = _Inputs.end(); i != i_end; ++i )
+				_ownData();
+
+				for ( auto i = _InputLabels.begin(), i_end = _InputLabels.end(); i != i_end; ++i )
 				{
-					auto NewInput = data.Input.find( i->first );
+					auto NewInput = data.Input.find( *i );
 
 					if ( NewInput != data.Input.end() )
-						i->second.push_back( data.Input[NewInput->first] );
+						_InputData.push_back( NewInput->second );
 					else
-						i->second.push_back( tNeurotransmitter() );
+						_InputData.push_back( tNeurotransmitter() );
 				}
 
-				for ( auto o = _Outputs.begin(), o_end = _Outputs.end(); o != o_end; ++o )
+				for ( auto o = _OutputLabels.begin(), o_end = _OutputLabels.end(); o != o_end; ++o )
 				{
-					auto NewOutput = data.Output.find( o->first );
+					auto NewOutput = data.Output.find( *o );
 
 					if ( NewOutput != data.Output.end() )
-						o->second.push_back( data.Output[NewOutput->first] );
+						_OutputData.push_back( NewOutput->second );
 					else
-						o->second.push_back( tNeurotransmitter() );
+						_OutputData.push_back( tNeurotransmitter() );
+				}
+
+				++_Size;
+			}
+
+			// Same, but with the values already in column order
+			void AddRecord( const tNeurotransmitter *input, const tNeurotransmitter *output )
+			{
+				_ownData();
+
+				_InputData.insert( _InputData.end(), input, input + _InputLabels.size() );
+				_OutputData.insert( _OutputData.end(), output, output + _OutputLabels.size() );
+				++_Size;
+			}
+
+			// Writes the set to a binary training file (see TrainingFile.hpp)
+			void Save( const std::string &fileName ) const
+			{
+				tTrainingFileWriter< tNeurotransmitter > Writer( fileName, _InputLabels, _OutputLabels );
+
+				for ( size_t r = 0; r < _Size; ++r )
+				{
+					tRecord CurRecord = Record( r );
+					Writer.AddRecord( CurRecord.Input, CurRecord.Output );
 				}
+
+				Writer.Close();
+			}
+
+			// Replaces the set with the contents of a binary training file -- Mapped and used in place if the file holds our value type, otherwise read in and converted
+			void Open( const std::string &fileName )
+			{
+				auto Mapping = std::make_shared< MappedFile >( fileName );
+				TrainingFile::tHeader Header;
+
+				TrainingFile::ReadHeader( Mapping->Data(), Mapping->Size(), Header );
+
+				if ( !_sortedLabels(Header.InputLabels) || !_sortedLabels(Header.OutputLabels) )
+					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tTrainingSet<>::Open(): Columns in '") + fileName + std::string("' are not sorted.") );
+
+				Clear();
+
+				_InputLabels = Header.InputLabels;
+				_OutputLabels = Header.OutputLabels;
+				_Size = size_t( Header.NumRecords );
+
+				const unsigned char *Inputs = Mapping->Data() + Header.DataOffset;
+				const unsigned char *Outputs = Mapping->Data() + Header.OutputOffset();
+
+				if ( _mappable(Header) )
+				{
+					_Mapping = Mapping;
+					_MappedInput = reinterpret_cast< const tNeurotransmitter * >( Inputs );
+					_MappedOutput = reinterpret_cast< const tNeurotransmitter * >( Outputs );
+					return;
+				}
+
+				const size_t ValueSize = TrainingFile::ValueSize( Header.ValueType );
+
+				_InputData.resize( _Size * _InputLabels.size() );
+				_OutputData.resize( _Size * _OutputLabels.size() );
+
+				for ( size_t v = 0, v_end = _InputData.size(); v < v_end; ++v )
+					_InputData[ v ] = TrainingFile::ReadValue< tNeurotransmitter >( Inputs + (v * ValueSize), Header.ValueType );
+
+				for ( size_t v = 0, v_end = _OutputData.size(); v < v_end; ++v )
+					_OutputData[ v ] = TrainingFile::ReadValue< tNeurotransmitter >( Outputs + (v * ValueSize), Header.ValueType );
+			}
+
+			// Whether the set is using a mapped file in place
+			bool Mapped() const
+			{
+				return bool( _Mapping );
+			}
+
+			// Matches our columns up with a network's inputs/outputs (given in the network's order)
+			tBinding Bind( const tLabels &inputs, const tLabels &outputs ) const
+			{
+				tBinding Binding;
+
+				Binding.Input = _bindColumns( _InputLabels, inputs, "Input" );
+				Binding.Output = _bindColumns( _OutputLabels, outputs, "Output" );
+				Binding.Direct = (inputs == _InputLabels && outputs == _OutputLabels);
+
+				return Binding;
+			}
+
+			tBinding Bind( const ttGanglion &network ) const
+			{
+				tLabels Inputs, Outputs;
+
+				for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i )
+					Inputs.push_back( i->first );
+
+				for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
+					Outputs.push_back( o->first );
+
+				return Bind( Inputs, Outputs );
 			}
 
 		protected:
-			std::map< std::string, std::vector<tNeurotransmitter> >		_Inputs;
-			std::map< std::string, std::vector<tNeurotransmitter> >		_Outputs;
+			tLabels				_InputLabels;		// Kept sorted
+			tLabels				_OutputLabels;		// Kept sorted
+			tValues				_InputData;			// Row-major, one row per record
+			tValues				_OutputData;		// Row-major, one row per record
+			size_t				_Size;
+
+			MappedFile::Ptr				_Mapping;			// Set when we're using an Open()ed file in place of _InputData/_OutputData
+			const tNeurotransmitter *	_MappedInput;
+			const tNeurotransmitter *	_MappedOutput;
+
+		protected:
+			// Copies mapped data into memory so it can be changed
+			void _ownData()
+			{
+				if ( !_Mapping )
+					return;
+
+				_InputData.assign( _MappedInput, _MappedInput + (_Size * _InputLabels.size()) );
+				_OutputData.assign( _MappedOutput, _MappedOutput + (_Size * _OutputLabels.size()) );
+
+				_Mapping.reset();
+				_MappedInput = NULL;
+				_MappedOutput = NULL;
+			}
+
+			static bool _sortedLabels( const tLabels &labels )
+			{
+				for ( size_t l = 1, l_end = labels.size(); l < l_end; ++l )
+				{
+					if ( !(labels[l - 1] < labels[l]) )
+						return false;
+				}
+
+				return true;
+			}
+
+			// Whether a file's data can be used as-is
+			static bool _mappable( const TrainingFile::tHeader &header )
+			{
+				if ( !std::is_same<tNeurotransmitter, float>::value && !std::is_same<tNeurotransmitter, double>::value )
+					return false;
+
+				return header.ValueType == (std::is_same<tNeurotransmitter, float>::value ? TrainingFile::Float : TrainingFile::Double)
+					&& TrainingFile::LittleEndian()
+					&& (header.DataOffset % alignof(tNeurotransmitter)) == 0
+					&& (header.OutputOffset() % alignof(tNeurotransmitter)) == 0;
+			}
+
+			// Adds a column (in label order), or resets an existing one
+			void _addColumn( tLabels &labels, tValues &data, const std::string &label )
+			{
+				_ownData();
+
+				const size_t OldColumns = labels.size();
+				auto Position = std::lower_bound( labels.begin(), labels.end(), label );
+				size_t Column = Position - labels.begin();
+
+				if ( Position != labels.end() && *Position == label )
+				{
+					for ( size_t r = 0; r < _Size; ++r )
+						data[ (r * OldColumns) + Column ] = tNeurotransmitter();
+
+					return;
+				}
+
+				labels.insert( Position, label );
+
+				tValues NewData( _Size * (OldColumns + 1) );
+
+				for ( size_t r = 0; r < _Size; ++r )
+				{
+					auto OldRow = data.begin() + (r * OldColumns);
+					auto NewRow = NewData.begin() + (r * (OldColumns + 1));
+
+					std::copy( OldRow, OldRow + Column, NewRow );
+					std::copy( OldRow + Column, OldRow + OldColumns, NewRow + Column + 1 );
+				}
+
+				data.swap( NewData );
+			}
+
+			// Every one of our columns has to be used by the network
+			static std::vector< size_t > _bindColumns( const tLabels &ourLabels, const tLabels &networkLabels, const char *type )
+			{
+				std::vector< size_t > Columns( networkLabels.size(), NoColumn );
+				size_t NumBound = 0;
+
+				for ( size_t n = 0, n_end = networkLabels.size(); n < n_end; ++n )
+				{
+					auto Column = std::lower_bound( ourLabels.begin(), ourLabels.end(), networkLabels[n] );
+
+					if ( Column != ourLabels.end() && *Column == networkLabels[n] )
+					{
+						Columns[ n ] = Column - ourLabels.begin();
+						++NumBound;
+					}
+				}
+
+				if ( NumBound != ourLabels.size() )
+				{
+					for ( auto l = ourLabels.begin(), l_end = ourLabels.end(); l != l_end; ++l )
+					{
+						if ( std::find(networkLabels.begin(), networkLabels.end(), *l) == networkLabels.end() )
+							throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tTrainingSet<>::Bind(): ") + type + std::string(" '") + *l + std::string("' not found in the network.") );
+					}
+				}
+
+				return Columns;
+			}
 		};
 
-		typedef tTrainingSet<>		TrainingSet;
+		typedef tTrainingSet<>					TrainingSet;
+		typedef tTrainingSet< FloatGanglion >	FloatTrainingSet;
 
 
 		namespace Default
@@ -226,16 +645,24 @@ namespace Toolbox
 				template <typename tType>
 				tType MeanSquared( const tType &value )
 				{
-					tNeurotransmitter Error = tNeurotransmitter(0.5) * (value * value);
+					tType Error = tType(0.5) * (value * value);
 					return Error;
 				}
 
 				template <typename tType>
 				tType ArcTan( const tType &value )
 				{
-					tNeurotransmitter Error = atan( value );
+					tType Error = std::atan( value );
 					return Error * Error;
 				}
+
+				// For softmax outputs -- Takes the output itself rather than its difference from the target (an output of 0 counts as the smallest positive value, rather than infinitely wrong)
+				template <typename tType>
+				tType CrossEntropy( const tType &target, const tType &value )
+				{
+					tType Error = -target * std::log( std::max(value, std::numeric_limits<tType>::min()) );
+					return Error;
+				}
 			}
 		}
 
@@ -244,24 +671,42 @@ namespace Toolbox
 		// The default trainer trains multi-layer backprop by default
 		//
 		template <typename _tGanglion = Ganglion>
-		class tTrainer : public std::enable_shared_from_this< tTrainer<typename _tGanglion::tNeurotransmitter> >
+		class tTrainer : public std::enable_shared_from_this< tTrainer<_tGanglion> >
 		{
 		public:
 			typedef _tGanglion										ttGanglion;
 			typedef typename ttGanglion::tNeurotransmitter			tNeurotransmitter;
-			typedef tNeuron< tNeurotransmitter >					ttNeuron;
+			typedef typename ttGanglion::ttNeuron					ttNeuron;
 			typedef tLabeledNeuron< typename ttGanglion::tNucleus >	ttLabeledNeuron;
 			typedef tTrainingData< tNeurotransmitter >				ttTrainingData;
 			typedef tTrainingSet< ttGanglion >						ttTrainingSet;
+			typedef typename ttGanglion::ttCompiledGanglion			ttCompiledGanglion;
+			typedef typename ttCompiledGanglion::tValues			tValues;
+			typedef tOptimizer< tNeurotransmitter >					ttOptimizer;
+			typedef tSchedule< tNeurotransmitter >					ttSchedule;
+			typedef tProfiler< tNeurotransmitter >					ttProfiler;
 
 			TOOLBOX_POINTERS( tTrainer<tNeurotransmitter> )
 
 		public:
 			tNeurotransmitter										LearningRate;
-			tNeurotransmitter										Momentum;
+			tNeurotransmitter										Momentum;				// Unused (see the notes above) -- Give the Optimizer a momentum instead
 			tNeurotransmitter										AllowedError;			// The allowed margin of error to be considered "trained"
 			size_t													MaxTrainingCycles;		// Max overall training cycles -- 0 allows infinite
 			size_t													MaxProcessingCycles;	// Max network processing cycles per each forward pass -- 0 allows infinite
+			size_t													Threads;				// Threads to split each batch across -- 0 uses the original, single threaded trainer
+			size_t													BatchSize;				// Records per weight update for MiniBatchTrain()
+			bool													Shuffle;				// Shuffle the records at the start of each training cycle
+			unsigned int											Seed;					// Starting point for the shuffling (and Dropout)
+			typename ttOptimizer::Ptr								Optimizer;				// Turns gradients into weight updates -- NULL uses tSGD<> (the original behavior)
+			size_t													Patience;				// Cycles without improvement before giving up -- 0 keeps going
+			bool													RestoreBest;			// Go back to the best weights seen on the validation set if training stops short
+			typename ttSchedule::Ptr								Schedule;				// Picks the learning rate for each cycle -- NULL always uses LearningRate
+			typename ttProfiler::Ptr								Profiler;				// Hears about every training cycle -- Only with TOOLBOX_NEURALNETWORK_PROFILE defined (see Profile.hpp)
+			tNeurotransmitter										Dropout;				// Chance of leaving out each hidden neuron for a record -- Trains a compiled copy of the network
+			tNeurotransmitter										L1;						// Adds L1 * sign(weight) to each weight's gradient
+			tNeurotransmitter										L2;						// Adds L2 * weight to each weight's gradient
+			tNeurotransmitter										WeightDecay;			// Each update also takes LearningRate * WeightDecay * weight off of each weight
 
 		public:
 			tTrainer():
@@ -269,7 +714,17 @@ namespace Toolbox
 				Momentum( tNeurotransmitter(Default::Momentum) ),
 				AllowedError( tNeurotransmitter(Default::AllowedError) ),
 				MaxTrainingCycles( Default::MaxTrainingCycles ),
-				MaxProcessingCycles( Default::MaxProcessingCycles )
+				MaxProcessingCycles( Default::MaxProcessingCycles ),
+				Threads( Default::TrainingThreads ),
+				BatchSize( Default::BatchSize ),
+				Shuffle( Default::Shuffle ),
+				Seed( Default::Seed ),
+				Patience( Default::Patience ),
+				RestoreBest( Default::RestoreBest ),
+				Dropout( tNeurotransmitter(Default::Dropout) ),
+				L1( tNeurotransmitter(Default::L1) ),
+				L2( tNeurotransmitter(Default::L2) ),
+				WeightDecay( tNeurotransmitter(Default::WeightDecay) )
 			{
 			}
 
@@ -278,7 +733,17 @@ namespace Toolbox
 				Momentum( momentum ),
 				AllowedError( marginOfError ),
 				MaxTrainingCycles( maxTrainingCycles ),
-				MaxProcessingCycles( maxProcessingCycles )
+				MaxProcessingCycles( maxProcessingCycles ),
+				Threads( Default::TrainingThreads ),
+				BatchSize( Default::BatchSize ),
+				Shuffle( Default::Shuffle ),
+				Seed( Default::Seed ),
+				Patience( Default::Patience ),
+				RestoreBest( Default::RestoreBest ),
+				Dropout( tNeurotransmitter(Default::Dropout) ),
+				L1( tNeurotransmitter(Default::L1) ),
+				L2( tNeurotransmitter(Default::L2) ),
+				WeightDecay( tNeurotransmitter(Default::WeightDecay) )
 			{
 			}
 
@@ -295,186 +760,424 @@ namespace Toolbox
 			// Incremental training updates the weights after each run of the network, whereas batch training only updates after the entire set has been seen
 			virtual bool Train( ttGanglion &network, const ttTrainingSet &set, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL, bool incrementalTraining = true )
 			{
-				std::map< typename _Neuron<tNeurotransmitter>::Ptr, tNeurotransmitter >		_Error;
-				std::map< typename _Neuron<tNeurotransmitter>::Ptr,
-					std::map<typename _Neuron<tNeurotransmitter>::Ptr, tNeurotransmitter >>	_WeightUpdates, _PrevWeightUpdates;
+				return _train( network, set, NULL, networkError, numCycles, incrementalTraining ? 1 : 0 );
+			}
+
+			// Also checks the network against a separate validation set after every cycle, keeping track of the best weights (see Patience and RestoreBest)
+			virtual bool Train( ttGanglion &network, const ttTrainingSet &set, const ttTrainingSet &validation, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL, bool incrementalTraining = true )
+			{
+				return _train( network, set, &validation, networkError, numCycles, incrementalTraining ? 1 : 0 );
+			}
+
+			bool BatchTrain( ttGanglion &network, const ttTrainingSet &set, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL )
+			{
+				return this->Train( network, set, networkError, numCycles, false );
+			}
+
+			bool BatchTrain( ttGanglion &network, const ttTrainingSet &set, const ttTrainingSet &validation, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL )
+			{
+				return this->Train( network, set, validation, networkError, numCycles, false );
+			}
+
+			// Somewhere in between -- Updates the weights after every BatchSize records
+			bool MiniBatchTrain( ttGanglion &network, const ttTrainingSet &set, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL )
+			{
+				if ( BatchSize == 0 )
+					throw std::runtime_error("Toolbox::NeuralNetwork::Trainer::MiniBatchTrain(): BatchSize must be at least 1.");
+
+				return _train( network, set, NULL, networkError, numCycles, BatchSize );
+			}
+
+			bool MiniBatchTrain( ttGanglion &network, const ttTrainingSet &set, const ttTrainingSet &validation, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL )
+			{
+				if ( BatchSize == 0 )
+					throw std::runtime_error("Toolbox::NeuralNetwork::Trainer::MiniBatchTrain(): BatchSize must be at least 1.");
+
+				return _train( network, set, &validation, networkError, numCycles, BatchSize );
+			}
 
+
+			// Checks a data set and returns the network error for the set
+			bool Validate( ttGanglion &network, const ttTrainingSet &set = ttTrainingSet(), tNeurotransmitter *error = NULL )
+			{
 				tNeurotransmitter SetError = tNeurotransmitter();				// The total error for a set, and ultimately our return value
 				size_t TrainingSetSize = set.Size();
-				size_t NumOutputs = network.Output.size();
-				bool Trained = false;
 
-				if ( TrainingSetSize <= 0 )
-					throw std::runtime_error("Toolbox::NeuralNetwork::Trainer::Train(): Training set is empty.");
+				// Find where everything lives in the set, once
+				auto Binding = set.Bind( network );
+				std::vector< std::pair<typename ttGanglion::ttLabeledNeuron *, size_t> > InputNeurons;
+				std::vector< std::pair<size_t, size_t> > OutputColumns;		// Position in GetOutputs(), and the set's column
+				tValues Outputs;
 
-				// Until our margin of error is low enough or until we crap out
-				unsigned int CurCycle = 0;
-				for ( ; MaxTrainingCycles != 0 && CurCycle < MaxTrainingCycles; ++CurCycle )
+				size_t CurInput = 0;
+				for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i, ++CurInput )
 				{
-					SetError = tNeurotransmitter();
-					_PrevWeightUpdates.clear();
+					if ( Binding.Input[CurInput] != ttTrainingSet::NoColumn )
+						InputNeurons.push_back( std::make_pair(i->second.get(), Binding.Input[CurInput]) );
+				}
 
-					// Loop through our training set
-					for ( size_t CurRecord = 0; CurRecord < TrainingSetSize; ++CurRecord )
-					{
-						tTrainingData< tNeurotransmitter > Record = set.GetRecord( CurRecord );
+				for ( size_t CurOutput = 0, NumOutputs = network.Output.size(); CurOutput < NumOutputs; ++CurOutput )
+				{
+					if ( Binding.Output[CurOutput] != ttTrainingSet::NoColumn )
+						OutputColumns.push_back( std::make_pair(CurOutput, Binding.Output[CurOutput]) );
+				}
 
-						// Clear the errors from the previous round
-						tNeurotransmitter NetworkError = tNeurotransmitter();		// Calculated and compared each cycle
-						_Error.clear();
+				// The weights may have changed since the network was last processed
+				network.Invalidate();
 
-						// Prepare the network with the inputs
-						for ( auto i = Record.Input.begin(), i_end = Record.Input.end(); i != i_end; ++i )
-							network.SetInput( i->first, i->second );
+				// Loop through our validation set
+				for ( size_t CurRecord = 0; CurRecord < TrainingSetSize; ++CurRecord )
+				{
+					auto Record = set.Record( CurRecord );
 
-						// Process the network
-						network.Process( MaxProcessingCycles );
+					// Clear the errors from the previous round
+					tNeurotransmitter NetworkError = tNeurotransmitter();		// Calculated and compared each cycle
 
-						// Calculate the error of our output neurons
-						// Probably TODO: Multithread this loop (threadpool to process neurons?)
-						for ( auto o = Record.Output.begin(), o_end = Record.Output.end(); o != o_end; ++o )
-						{
-							auto OutputNeuron = network.GetOutputNeuron( o->first );
+					// Prepare the network with the inputs
+					for ( auto i = InputNeurons.begin(), i_end = InputNeurons.end(); i != i_end; ++i )
+						i->first->SetValue( Record.Input[i->second] );
 
-							if ( !OutputNeuron )
-								continue;
+					// Process the network
+					network.Process( MaxProcessingCycles );
+					network.GetOutputs( Outputs );
 
-							auto DesiredValue = o->second;
+					// Calculate the error of our output neurons
+					// Probably TODO: Multithread this loop (threadpool to process neurons?)
+					for ( auto o = OutputColumns.begin(), o_end = OutputColumns.end(); o != o_end; ++o )
+					{
+						// First calculate the error
+						NetworkError += _outputError( network.SoftmaxOutput, Outputs[o->first], Record.Output[o->second] );
 
-							// First calculate the error
-							tNeurotransmitter Error = OutputNeuron->Value() - DesiredValue;
-							_Error[ OutputNeuron ] = Error;
-							NetworkError += this->CalculateError( Error );
+						// Root MSE? -- Harder to genericize
+						//NetworkError = sqrt( NetworkError );
+					}
 
-							// Then update the weights
-							size_t NumOutputs = 0;
-							for ( auto d = OutputNeuron->Dendrites.begin(), d_end = OutputNeuron->Dendrites.end(); d != d_end; ++d )
-							{
-								auto DendriteNeuron = (d->first).lock();
+					SetError += NetworkError;
+				}
 
-								if ( !DendriteNeuron )
-									continue;
+				if ( error != NULL )
+					*error = SetError;
 
-								tNeurotransmitter CurMomentum = tNeurotransmitter();
+				return SetError <= AllowedError;
+			}
 
-								// Verify we have a previous weight to work with for our momentum
-								if ( !_PrevWeightUpdates.empty() )
-									CurMomentum = _PrevWeightUpdates[ OutputNeuron ][ DendriteNeuron ];
+		protected:
+			// A neuron being trained, and where its connections live in the tGraphIndex arrays
+			struct tTrainingNeuron
+			{
+				typename _Neuron<tNeurotransmitter>::Ptr	Neuron;
+				size_t										Target;			// Outputs only -- The training set column with our desired value
+				size_t										FirstDendrite;
+				size_t										NumDendrites;
+				size_t										FirstAxon;
+				size_t										NumAxons;
+			};
+
+			// Every neuron and connection we train, numbered once per training run -- Points straight into the network's own dendrite maps
+			struct tGraphIndex
+			{
+				std::vector< tTrainingNeuron >				Neurons;		// Outputs first, then each hidden layer in reverse order
+				size_t										NumOutputs;
 
-								tNeurotransmitter WeightUpdate = -LearningRate * Error * OutputNeuron->Nucleus.Derivation(OutputNeuron->Value()) * DendriteNeuron->Value();
-								_WeightUpdates[ OutputNeuron ][ DendriteNeuron ] += WeightUpdate + CurMomentum;
-								++NumOutputs;
-							}
+				std::vector< tNeurotransmitter * >			Weight;			// Per dendrite
+				std::vector< _Neuron<tNeurotransmitter> * >	Source;			// Per dendrite -- The neuron on the other end
 
-							// Root MSE? -- Harder to genericize
-							//NetworkError = sqrt( NetworkError );
-						}
+				std::vector< size_t >						AxonNeuron;		// Per axon -- Index into Neurons
+				std::vector< tNeurotransmitter * >			AxonWeight;		// Per axon -- The weight of the axon neuron's dendrite back to us
 
-						SetError += NetworkError;
+				const _Neuron<tNeurotransmitter> *			Bias;			// The network's BiasNeuron -- Its weights are never regularized
+			};
 
-						// Now, work backwards through the hidden layers calculating errors and updating weights
-						// TODO: Multithread this loop (threadpool to process neurons?)
-						// For each hidden layer (in reverse order)...
-						for ( auto l = network.Hidden.rbegin(), l_end = network.Hidden.rend(); l != l_end; ++l )
-						{
-							// We look at each neuron...
-							for ( auto h = l->second.begin(), h_end = l->second.end(); h != h_end; ++h )
-							{
-								auto HiddenNeuron = h->second;
+			tSGD< tNeurotransmitter >				_DefaultOptimizer;		// Used when Optimizer isn't set
 
-								// If it wasn't activated, we can ignore it and move on to the next
-								if ( !HiddenNeuron->Activated() )
-									continue;
+			// Everything one thread needs to run records through a compiled network, apart from the weights
+			struct tWorker
+			{
+				typename ttCompiledGanglion::tState		State;
+				std::vector< tValues >					Delta;			// Per layer -- Error * derivation of each neuron
+				std::vector< tValues >					Gradient;		// Per layer -- Same layout as the layer's Weights
+				std::vector< tValues >					BiasGradient;	// Per layer
+				std::vector< std::vector<unsigned char> >	Kept;		// Per hidden layer -- The neurons Dropout left in for the current record
+				tNeurotransmitter						Error;			// Total network error of the records seen
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				double									ForwardTime;	// Microseconds, for the profiler
+				double									BackwardTime;
+#endif
+			};
+
+			// A set laid out in a compiled network's input/output order (pointing straight at the set's own data when it already lines up)
+			struct tBoundSet
+			{
+				const tNeurotransmitter *				Inputs;
+				const tNeurotransmitter *				Targets;
+				size_t									Size;
+				tValues									BoundInputs;
+				tValues									BoundTargets;
+				std::vector< unsigned char >			HasOutput;		// Per output -- Whether the set has a target for it
+			};
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+			// What the current training cycle has done so far, for the profiler
+			struct _tEpochCounters
+			{
+				double									ForwardTime;	// Microseconds
+				double									BackwardTime;
+				double									ApplyTime;
+				size_t									Updates;
+				tNeurotransmitter						UpdateSquares;	// Sum of each update squared
+				tNeurotransmitter						MaxUpdate;
+			};
 
-								tNeurotransmitter Error = tNeurotransmitter();
-								tNeurotransmitter HiddenDerivation = HiddenNeuron->Nucleus.Derivation( HiddenNeuron->Value() );
+			_tEpochCounters							_EpochCounters;
+#endif
 
-								// And gather the total weighted error for this neuron from each of its axons
-								for ( auto a = HiddenNeuron->Axons.begin(), a_end = HiddenNeuron->Axons.end(); a != a_end; ++a )
-								{
-									auto Axon = a->lock();
-
-									if ( Axon )
-									{
-										// We should technically use the axon's derivation, but it should be the same as our hidden, so we're going to cheat here since we don't have the Axon nucleus...
-										tNeurotransmitter CurError = _Error[ Axon ] * HiddenNeuron->Nucleus.Derivation(Axon->Value()) * Axon->Dendrites[ HiddenNeuron ];
-										Error += CurError;
-									}
-								}
+		protected:
+			// Updates the weights after every 'batchSize' records (0 for the whole set at once)
+			bool _train( ttGanglion &network, const ttTrainingSet &set, const ttTrainingSet *validation, tNeurotransmitter *networkError, size_t *numCycles, size_t batchSize )
+			{
+				if ( Dropout < tNeurotransmitter() || Dropout >= tNeurotransmitter(1) )
+					throw std::runtime_error("Toolbox::NeuralNetwork::Trainer::Train(): Dropout must be at least 0 and less than 1.");
 
-								_Error[ HiddenNeuron ] = Error;
+				// Only looked into when a compiled copy would be used (the layering check walks the whole network)
+				const bool WantCompiled = (Threads > 0 || Dropout > tNeurotransmitter());
+				const bool Recurrent = tHasMemory< typename ttGanglion::ttNeuron >::value;
+				const bool Compilable = WantCompiled && !Recurrent && network.UseBias && (MaxProcessingCycles == 0 || MaxProcessingCycles > network.Hidden.size() + 1) && ttCompiledGanglion::Layered( network );
 
-								// Now that we know our error, calculate the weight updates
-								for ( auto d = HiddenNeuron->Dendrites.begin(), d_end = HiddenNeuron->Dendrites.end(); d != d_end; ++d )
-								{
-									auto DendriteNeuron = (d->first).lock();
+				if ( Dropout > tNeurotransmitter() && Recurrent )
+					throw std::runtime_error("Toolbox::NeuralNetwork::Trainer::Train(): Dropout isn't supported by recurrent networks.");
 
-									if ( !DendriteNeuron )
-										continue;
+				if ( Dropout > tNeurotransmitter() && !Compilable )
+					throw std::runtime_error("Toolbox::NeuralNetwork::Trainer::Train(): Dropout needs a layered network using a bias.");
 
-									tNeurotransmitter CurMomentum = tNeurotransmitter();
+				if ( Compilable )
+					return _trainCompiled( network, set, validation, networkError, numCycles, batchSize );
 
-									// Verify we have a previous weight to work with for our momentum
-									if ( !_PrevWeightUpdates.empty() )
-										CurMomentum = _PrevWeightUpdates[ HiddenNeuron ][ DendriteNeuron ];
+				tGraphIndex Index;
+				_indexNetwork( network, Index );
 
-									tNeurotransmitter WeightUpdate = -LearningRate * Error * HiddenDerivation * DendriteNeuron->Value();
-									_WeightUpdates[ HiddenNeuron ][ DendriteNeuron ] += WeightUpdate + CurMomentum;
-								}
-							}
-						}
+				// Find where everything lives in the set, once
+				auto Binding = set.Bind( network );
+				std::vector< std::pair<typename ttGanglion::ttLabeledNeuron *, size_t> > InputNeurons;
 
-						// If we're doing incremental training, then update the weights immediately after each record we've calculated them for
-						if ( incrementalTraining )
-						{
-							size_t WeightCount = 0;
-							for ( auto from = _WeightUpdates.begin(), from_end = _WeightUpdates.end(); from != from_end; ++from, ++WeightCount )
-							{
-								auto FromNeuron = from->first;
+				size_t CurInput = 0;
+				for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i, ++CurInput )
+				{
+					if ( Binding.Input[CurInput] != ttTrainingSet::NoColumn )
+						InputNeurons.push_back( std::make_pair(i->second.get(), Binding.Input[CurInput]) );
+				}
 
-								for ( auto to = from->second.begin(), to_end = from->second.end(); to != to_end; ++to )
-								{
-									auto ToNeuron = to->first;
-									auto WeightUpdate = to->second;
-									FromNeuron->Dendrites[ ToNeuron ] = FromNeuron->Dendrites[ ToNeuron ] + WeightUpdate;
-								}
-							}
+				for ( size_t o = 0; o < Index.NumOutputs; ++o )
+					Index.Neurons[ o ].Target = Binding.Output[ o ];
 
-							_PrevWeightUpdates = _WeightUpdates;
-							_WeightUpdates.clear();
-						}
-					}
+				const size_t NumNeurons = Index.Neurons.size();
+				const size_t NumConnections = Index.Weight.size();
 
-					// Sometimes interesting/helpful to see, but not something that should be "on" by default...candidate for a DEBUG flag or similar
-					//std::cout << "Cur Cycle: " << CurCycle << "  Error: " << SetError << "  (Allowed: " << AllowedError << ")" << std::endl;
+				// Allocated once and reused for every record of every cycle
+				tValues Delta( NumNeurons );		// Per neuron -- Its error times its derivative, for the neurons feeding it
+				tValues Outputs;					// Softmax outputs, from GetOutputs()
+				tValues Gradient( NumConnections ), WeightUpdates( NumConnections );
+				std::vector< unsigned char > Updated( NumNeurons, false );		// Which neurons have weight updates waiting
 
-					// If we get through the training set and have no errors, we're "trained" and should head to the validation set (if one was provided)
-					if ( SetError <= AllowedError )
-					{
-						Trained = true;
-						break;
-					}
+				auto CurOptimizer = _optimizer();
+				CurOptimizer->Reset( NumConnections );
 
-					// Batch training -- update weights after each entire set
-					if ( !incrementalTraining )
-					{
-						size_t WeightCount = 0;
-						for ( auto from = _WeightUpdates.begin(), from_end = _WeightUpdates.end(); from != from_end; ++from, ++WeightCount )
-						{
-							auto FromNeuron = from->first;
+				// _applyUpdates() leaves each weight's penalty in its gradient for next time, so the first update needs them up front
+				_seedPenalties( Index, Gradient );
 
-							for ( auto to = from->second.begin(), to_end = from->second.end(); to != to_end; ++to )
-							{
-								auto ToNeuron = to->first;
-								auto WeightUpdate = to->second;
-								FromNeuron->Dendrites[ ToNeuron ] = FromNeuron->Dendrites[ ToNeuron ] + WeightUpdate;
-							}
-						}
+				if ( Schedule )
+					Schedule->Reset();
 
-						_PrevWeightUpdates = _WeightUpdates;
-						_WeightUpdates.clear();
-					}
-				}
+				// The error we're watching for improvements -- The validation set's if we have one
+				tNeurotransmitter LastError = std::numeric_limits< tNeurotransmitter >::infinity();
+				tNeurotransmitter BestError = LastError;
+				size_t BestCycle = 0;
+				tValues BestWeights;
+
+				tNeurotransmitter SetError = tNeurotransmitter();				// The total error for a set, and ultimately our return value
+				size_t TrainingSetSize = set.Size();
+				bool Trained = false;
+
+				if ( TrainingSetSize <= 0 )
+					throw std::runtime_error("Toolbox::NeuralNetwork::Trainer::Train(): Training set is empty.");
+
+				typedef typename ttGanglion::ttNeuron		tTrainedNeuron;
+				const bool Softmax = network.SoftmaxOutput;
+
+				std::vector< size_t > Order( TrainingSetSize );
+				std::mt19937 Random( Seed );
+
+				for ( size_t r = 0; r < TrainingSetSize; ++r )
+					Order[ r ] = r;
+
+				// Until our margin of error is low enough or until we crap out
+				unsigned int CurCycle = 0;
+				for ( ; MaxTrainingCycles != 0 && CurCycle < MaxTrainingCycles; ++CurCycle )
+				{
+					SetError = tNeurotransmitter();
+					CurOptimizer->NewCycle();
+
+					tNeurotransmitter CurLearningRate = (Schedule ? Schedule->Rate(LearningRate, CurCycle, MaxTrainingCycles, LastError) : LearningRate);
+
+					if ( Shuffle )
+						_shuffle( Order, Random );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+					double EpochStart = _startEpoch();
+#endif
+
+					// Loop through our training set
+					for ( size_t CurRecord = 0; CurRecord < TrainingSetSize; ++CurRecord )
+					{
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						auto Mark = ttProfiler::tClock::now();
+#endif
+						auto Record = set.Record( Order[CurRecord] );
+
+						// Clear the errors from the previous round
+						tNeurotransmitter NetworkError = tNeurotransmitter();		// Calculated and compared each cycle
+						std::fill( Delta.begin(), Delta.end(), tNeurotransmitter() );
+
+						// Prepare the network with the inputs
+						for ( auto i = InputNeurons.begin(), i_end = InputNeurons.end(); i != i_end; ++i )
+							i->first->SetValue( Record.Input[i->second] );
+
+						// Process the network (all of it, since the weights keep changing)
+						network.Invalidate();
+						network.Process( MaxProcessingCycles );
+
+						if ( Softmax )
+							network.GetOutputs( Outputs );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						_EpochCounters.ForwardTime += _lap( Mark );
+#endif
+
+						// The outputs come first in our index, then the hidden layers (in reverse order), so this works backwards through the network
+						for ( size_t n = 0; n < NumNeurons; ++n )
+						{
+							const tTrainingNeuron &CurNeuron = Index.Neurons[ n ];
+							tNeurotransmitter CurError = tNeurotransmitter();
+							tNeurotransmitter CurDelta = tNeurotransmitter();
+
+							if ( n < Index.NumOutputs && Softmax )
+							{
+								// Cross-entropy through the softmax, differentiated together -- Comes out to (output - target) for each output's sum
+								const bool HasTarget = (CurNeuron.Target != ttTrainingSet::NoColumn);
+								tNeurotransmitter Target = (HasTarget ? Record.Output[CurNeuron.Target] : tNeurotransmitter());
+
+								if ( HasTarget )
+									NetworkError += Default::ErrorFunc::CrossEntropy( Target, Outputs[n] );
+
+								CurDelta = Outputs[ n ] - Target;
+							}
+							else
+							{
+								if ( n < Index.NumOutputs )
+								{
+									if ( CurNeuron.Target == ttTrainingSet::NoColumn )
+										continue;
+
+									// First calculate the error
+									CurError = CurNeuron.Neuron->Value() - Record.Output[ CurNeuron.Target ];
+									NetworkError += this->CalculateError( CurError );
+								}
+								else
+								{
+									// If it wasn't activated, we can ignore it and move on to the next
+									if ( !CurNeuron.Neuron->Activated() )
+										continue;
+
+									// Gather the total weighted error for this neuron from each of its axons
+									for ( size_t a = CurNeuron.FirstAxon, a_end = CurNeuron.FirstAxon + CurNeuron.NumAxons; a < a_end; ++a )
+										CurError += Delta[ Index.AxonNeuron[a] ] * *(Index.AxonWeight[ a ]);
+								}
+
+								CurDelta = CurError * tTrainedNeuron::Derive( CurNeuron.Neuron->Value() );
+							}
+
+							// Now that we know our error, calculate the gradients
+							Delta[ n ] = CurDelta;
+
+							for ( size_t d = CurNeuron.FirstDendrite, d_end = CurNeuron.FirstDendrite + CurNeuron.NumDendrites; d < d_end; ++d )
+								Gradient[ d ] += CurDelta * Index.Source[d]->Value();
+
+							Updated[ n ] = true;
+						}
+
+						SetError += NetworkError;
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						_EpochCounters.BackwardTime += _lap( Mark );
+#endif
+
+						// Incremental (and mini-batch) training updates the weights as soon as each batch of records has been seen
+						if ( batchSize != 0 && ((CurRecord + 1) % batchSize == 0 || CurRecord + 1 == TrainingSetSize) )
+						{
+							_applyUpdates( Index, *CurOptimizer, Updated, Gradient, WeightUpdates, CurLearningRate );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+							_EpochCounters.ApplyTime += _lap( Mark );
+#endif
+						}
+					}
+
+					// If we get through the training set and have no errors, we're "trained" and should head to the validation set (if one was provided)
+					if ( SetError <= AllowedError )
+					{
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						_endEpoch( EpochStart, CurCycle, TrainingSetSize, SetError, CurLearningRate );
+#endif
+						Trained = true;
+						break;
+					}
+
+					// Batch training -- update weights after each entire set
+					if ( batchSize == 0 )
+					{
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						auto Mark = ttProfiler::tClock::now();
+#endif
+						_applyUpdates( Index, *CurOptimizer, Updated, Gradient, WeightUpdates, CurLearningRate );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						_EpochCounters.ApplyTime += _lap( Mark );
+#endif
+					}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+					_endEpoch( EpochStart, CurCycle, TrainingSetSize, SetError, CurLearningRate );
+#endif
+
+					LastError = SetError;
+
+					if ( validation )
+						this->Validate( network, *validation, &LastError );
+
+					if ( LastError < BestError )
+					{
+						BestError = LastError;
+						BestCycle = CurCycle;
+
+						// Checkpoint the weights that did best on the validation set
+						if ( validation && RestoreBest )
+						{
+							BestWeights.resize( NumConnections );
+
+							for ( size_t d = 0; d < NumConnections; ++d )
+								BestWeights[ d ] = *(Index.Weight[ d ]);
+						}
+					}
+					else if ( Patience != 0 && CurCycle - BestCycle >= Patience )
+						break;
+				}
+
+				if ( !Trained && !BestWeights.empty() )
+				{
+					for ( size_t d = 0; d < NumConnections; ++d )
+						*(Index.Weight[ d ]) = BestWeights[ d ];
+				}
+
+				network.Invalidate();
 
 				if ( numCycles )
 					*numCycles = CurCycle;
@@ -485,64 +1188,698 @@ namespace Toolbox
 				return Trained;
 			}
 
-			bool BatchTrain( ttGanglion &network, const ttTrainingSet &set, tNeurotransmitter *networkError = NULL, size_t *numCycles = NULL )
+			void _indexNetwork( ttGanglion &network, tGraphIndex &index )
 			{
-				return this->Train( network, set, networkError, numCycles, false );
+				std::map< const _Neuron<tNeurotransmitter> *, size_t > NeuronIndex;
+
+				index = tGraphIndex();
+				index.Bias = network.BiasNeuron.get();
+
+				for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
+				{
+					tTrainingNeuron CurNeuron = tTrainingNeuron();
+					CurNeuron.Neuron = o->second;
+					CurNeuron.Target = ttTrainingSet::NoColumn;
+
+					NeuronIndex[ CurNeuron.Neuron.get() ] = index.Neurons.size();
+					index.Neurons.push_back( CurNeuron );
+				}
+
+				index.NumOutputs = index.Neurons.size();
+
+				for ( auto l = network.Hidden.rbegin(), l_end = network.Hidden.rend(); l != l_end; ++l )
+				{
+					for ( auto h = l->second.begin(), h_end = l->second.end(); h != h_end; ++h )
+					{
+						tTrainingNeuron CurNeuron = tTrainingNeuron();
+						CurNeuron.Neuron = h->second;
+
+						NeuronIndex[ CurNeuron.Neuron.get() ] = index.Neurons.size();
+						index.Neurons.push_back( CurNeuron );
+					}
+				}
+
+				for ( size_t n = 0, n_end = index.Neurons.size(); n < n_end; ++n )
+				{
+					tTrainingNeuron &CurNeuron = index.Neurons[ n ];
+					auto Neuron = CurNeuron.Neuron;
+
+					CurNeuron.FirstDendrite = index.Weight.size();
+
+					for ( auto d = Neuron->Dendrites.begin(), d_end = Neuron->Dendrites.end(); d != d_end; ++d )
+					{
+						auto DendriteNeuron = (d->first).lock();
+
+						if ( !DendriteNeuron )
+							continue;
+
+						index.Weight.push_back( &d->second );
+						index.Source.push_back( DendriteNeuron.get() );
+					}
+
+					CurNeuron.NumDendrites = index.Weight.size() - CurNeuron.FirstDendrite;
+
+					// Outputs don't pass any error back through their axons
+					if ( n < index.NumOutputs )
+						continue;
+
+					CurNeuron.FirstAxon = index.AxonNeuron.size();
+
+					for ( auto a = Neuron->Axons.begin(), a_end = Neuron->Axons.end(); a != a_end; ++a )
+					{
+						auto Axon = a->lock();
+
+						if ( !Axon )
+							continue;
+
+						auto AxonIndex = NeuronIndex.find( Axon.get() );
+
+						// Nothing we train, so it never has an error to pass back
+						if ( AxonIndex == NeuronIndex.end() )
+							continue;
+
+						index.AxonNeuron.push_back( AxonIndex->second );
+						index.AxonWeight.push_back( &(Axon->Dendrites[ Neuron ]) );
+					}
+
+					CurNeuron.NumAxons = index.AxonNeuron.size() - CurNeuron.FirstAxon;
+				}
 			}
 
-			// Checks a data set and returns the network error for the set
-			bool Validate( ttGanglion &network, const ttTrainingSet &set = ttTrainingSet(), tNeurotransmitter *error = NULL )
+			ttOptimizer *_optimizer()
 			{
-				tNeurotransmitter SetError = tNeurotransmitter();				// The total error for a set, and ultimately our return value
+				return Optimizer ? Optimizer.get() : &_DefaultOptimizer;
+			}
+
+			// Turns the gradients gathered so far into weight updates, and applies them
+			void _applyUpdates( tGraphIndex &index, ttOptimizer &optimizer, std::vector<unsigned char> &updated, tValues &gradient, tValues &weightUpdates, tNeurotransmitter learningRate )
+			{
+				const bool Regularized = _regularized();
+				const tNeurotransmitter Decay = learningRate * WeightDecay;
+
+				optimizer.NewUpdate();
+
+				for ( size_t n = 0, n_end = index.Neurons.size(); n < n_end; ++n )
+				{
+					const tTrainingNeuron &CurNeuron = index.Neurons[ n ];
+
+					// Neurons that were skipped entirely don't carry anything forward
+					if ( !updated[n] )
+					{
+						optimizer.Skip( CurNeuron.FirstDendrite, CurNeuron.NumDendrites );
+						continue;
+					}
+
+					optimizer.Step( &gradient[CurNeuron.FirstDendrite], &weightUpdates[CurNeuron.FirstDendrite], CurNeuron.FirstDendrite, CurNeuron.NumDendrites, learningRate );
+
+					// The gradient starts over from the penalty on the weight's new value
+					for ( size_t d = CurNeuron.FirstDendrite, d_end = CurNeuron.FirstDendrite + CurNeuron.NumDendrites; d < d_end; ++d )
+					{
+						tNeurotransmitter &Weight = *(index.Weight[ d ]);
+
+						if ( !Regularized || index.Source[d] == index.Bias )
+						{
+							Weight += weightUpdates[ d ];
+							gradient[ d ] = tNeurotransmitter();
+							continue;
+						}
+
+						Weight += weightUpdates[ d ] - (Decay * Weight);
+						gradient[ d ] = _penalty( Weight );
+					}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+					_countUpdates( &weightUpdates[CurNeuron.FirstDendrite], CurNeuron.NumDendrites );
+#endif
+				}
+
+				std::fill( updated.begin(), updated.end(), false );
+			}
+
+			// An output's share of the network error -- Softmax outputs are scored by cross-entropy, everything else by CalculateError()
+			tNeurotransmitter _outputError( bool softmax, const tNeurotransmitter &output, const tNeurotransmitter &target )
+			{
+				if ( softmax )
+					return Default::ErrorFunc::CrossEntropy( target, output );
+
+				return this->CalculateError( output - target );
+			}
+
+			bool _regularized() const
+			{
+				return L1 != tNeurotransmitter() || L2 != tNeurotransmitter() || WeightDecay != tNeurotransmitter();
+			}
+
+			// The L1/L2 penalties' share of a weight's gradient
+			tNeurotransmitter _penalty( tNeurotransmitter weight ) const
+			{
+				return (L2 * weight) + (weight > tNeurotransmitter() ? L1 : (weight < tNeurotransmitter() ? -L1 : tNeurotransmitter()));
+			}
+
+			// Starts each (non-bias) gradient off with its weight's penalty
+			void _seedPenalties( const tGraphIndex &index, tValues &gradient ) const
+			{
+				if ( !_regularized() )
+					return;
+
+				for ( size_t d = 0, d_end = index.Weight.size(); d < d_end; ++d )
+				{
+					if ( index.Source[d] != index.Bias )
+						gradient[ d ] += _penalty( *(index.Weight[d]) );
+				}
+			}
+
+			// Splitmix64's finalizer -- Every bit of the result depends on every bit of 'x'
+			static uint64_t _mix( uint64_t x )
+			{
+				x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+				x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+				return x ^ (x >> 31);
+			}
+
+			// Fisher-Yates, with our own index picking so a seed gives the same order everywhere
+			static void _shuffle( std::vector<size_t> &order, std::mt19937 &random )
+			{
+				for ( size_t i = order.size(); i > 1; --i )
+					std::swap( order[i - 1], order[size_t(random() % i)] );
+			}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+			// Microseconds since 'mark', moving 'mark' up to now
+			static double _lap( typename ttProfiler::tClock::time_point &mark )
+			{
+				auto Now = ttProfiler::tClock::now();
+				double Elapsed = std::chrono::duration< double, std::micro >( Now - mark ).count();
+
+				mark = Now;
+				return Elapsed;
+			}
+
+			double _startEpoch()
+			{
+				_EpochCounters = _tEpochCounters();
+
+				return Profiler ? Profiler->Now() : 0.0;
+			}
+
+			void _endEpoch( double start, size_t cycle, size_t records, tNeurotransmitter error, tNeurotransmitter learningRate )
+			{
+				if ( !Profiler )
+					return;
+
+				typename ttProfiler::tEpoch Epoch = typename ttProfiler::tEpoch();
+				Epoch.Cycle = cycle;
+				Epoch.Records = records;
+				Epoch.Error = error;
+				Epoch.LearningRate = learningRate;
+				Epoch.ForwardTime = _EpochCounters.ForwardTime;
+				Epoch.BackwardTime = _EpochCounters.BackwardTime;
+				Epoch.ApplyTime = _EpochCounters.ApplyTime;
+				Epoch.Updates = _EpochCounters.Updates;
+				Epoch.UpdateRMS = (_EpochCounters.Updates != 0 ? std::sqrt(_EpochCounters.UpdateSquares / tNeurotransmitter(_EpochCounters.Updates)) : tNeurotransmitter());
+				Epoch.MaxUpdate = _EpochCounters.MaxUpdate;
+
+				Profiler->AddEpoch( start, Epoch );
+			}
+
+			// Adds weight updates to the cycle's totals -- Only the ones flagged in 'applied', if given
+			void _countUpdates( const tNeurotransmitter *updates, size_t count, const unsigned char *applied = NULL )
+			{
+				for ( size_t u = 0; u < count; ++u )
+				{
+					if ( applied && !applied[u] )
+						continue;
+
+					tNeurotransmitter Size = std::abs( updates[u] );
+
+					++_EpochCounters.Updates;
+					_EpochCounters.UpdateSquares += Size * Size;
+					_EpochCounters.MaxUpdate = std::max( _EpochCounters.MaxUpdate, Size );
+				}
+			}
+#endif
+
+			bool _trainCompiled( ttGanglion &network, const ttTrainingSet &set, const ttTrainingSet *validation, tNeurotransmitter *networkError, size_t *numCycles, size_t batchSize )
+			{
+				tNeurotransmitter SetError = tNeurotransmitter();
 				size_t TrainingSetSize = set.Size();
-				size_t NumOutputs = network.Output.size();
 				bool Trained = false;
 
-				// Loop through our validation set
-				for ( size_t CurRecord = 0; CurRecord < TrainingSetSize; ++CurRecord )
+				if ( TrainingSetSize <= 0 )
+					throw std::runtime_error("Toolbox::NeuralNetwork::Trainer::Train(): Training set is empty.");
+
+				ttCompiledGanglion Compiled = network.Compile();
+				const size_t NumIn = Compiled.NumInputs();
+				const size_t NumOut = Compiled.NumOutputs();
+				const size_t NumLayers = Compiled.Layers.size();
+
+				tBoundSet Bound, BoundValidation;
+				_bindSet( Compiled, set, Bound );
+
+				const tNeurotransmitter *Inputs = Bound.Inputs;
+				const tNeurotransmitter *Targets = Bound.Targets;
+				const std::vector< unsigned char > &HasOutput = Bound.HasOutput;
+				tValues ValidationOutputs;
+
+				if ( validation )
 				{
-					tTrainingData< tNeurotransmitter > Record = set.GetRecord( CurRecord );
+					_bindSet( Compiled, *validation, BoundValidation );
+					ValidationOutputs.resize( BoundValidation.Size * NumOut );
+				}
 
-					// Clear the errors from the previous round
-					tNeurotransmitter NetworkError = tNeurotransmitter();		// Calculated and compared each cycle
+				// Incremental training is just batch training with a batch size of one
+				const size_t CurBatchSize = (batchSize != 0 ? std::min(batchSize, TrainingSetSize) : TrainingSetSize);
+				const size_t NumWorkers = std::min( std::max(Threads, size_t(1)), CurBatchSize );
 
-					// Prepare the network with the inputs
-					for ( auto i = Record.Input.begin(), i_end = Record.Input.end(); i != i_end; ++i )
-						network.SetInput( i->first, i->second );
+				std::vector< size_t > Order( TrainingSetSize );
+				std::mt19937 Random( Seed );
 
-					// Process the network
-					network.Process( MaxProcessingCycles );
+				for ( size_t r = 0; r < TrainingSetSize; ++r )
+					Order[ r ] = r;
 
-					// Calculate the error of our output neurons
-					// Probably TODO: Multithread this loop (threadpool to process neurons?)
-					for ( auto o = Record.Output.begin(), o_end = Record.Output.end(); o != o_end; ++o )
+				WorkerPool Pool( NumWorkers );
+				std::vector< tWorker > Workers( NumWorkers );
+
+				for ( auto w = Workers.begin(), w_end = Workers.end(); w != w_end; ++w )
+				{
+					w->State = Compiled.State;
+					w->Delta.resize( NumLayers );
+					w->Gradient.resize( NumLayers );
+					w->BiasGradient.resize( NumLayers );
+
+					for ( size_t l = 0; l < NumLayers; ++l )
+						w->Delta[ l ].resize( Compiled.Layers[l].NumNeurons );
+
+					if ( Dropout > tNeurotransmitter() )
 					{
-						auto OutputNeuron = network.GetOutputNeuron( o->first );
+						w->Kept.resize( NumLayers - 1 );
 
-						if ( !OutputNeuron )
-							continue;
+						for ( size_t l = 0; l + 1 < NumLayers; ++l )
+							w->Kept[ l ].resize( Compiled.Layers[l].NumNeurons );
+					}
+				}
 
-						auto DesiredValue = o->second;
+				// The optimizer numbers the weights layer by layer, with each layer's bias weights after the rest
+				size_t NumWeights = 0;
 
-						// First calculate the error
-						tNeurotransmitter Error = OutputNeuron->Value() - DesiredValue;
-						NetworkError += this->CalculateError( Error );
+				for ( size_t l = 0; l < NumLayers; ++l )
+					NumWeights += Compiled.Layers[ l ].Weights.size() + Compiled.Layers[ l ].NumNeurons;
 
-						// Root MSE? -- Harder to genericize
-						//NetworkError = sqrt( NetworkError );
+				tValues Gradient( NumWeights ), WeightUpdates( NumWeights );
+
+				auto CurOptimizer = _optimizer();
+				CurOptimizer->Reset( NumWeights );
+
+				if ( Schedule )
+					Schedule->Reset();
+
+				tNeurotransmitter LastError = std::numeric_limits< tNeurotransmitter >::infinity();
+				tNeurotransmitter BestError = LastError;
+				size_t BestCycle = 0;
+				typename ttCompiledGanglion::tLayers BestLayers;
+
+				unsigned int CurCycle = 0;
+				for ( ; MaxTrainingCycles != 0 && CurCycle < MaxTrainingCycles; ++CurCycle )
+				{
+					SetError = tNeurotransmitter();
+					CurOptimizer->NewCycle();
+
+					tNeurotransmitter CurLearningRate = (Schedule ? Schedule->Rate(LearningRate, CurCycle, MaxTrainingCycles, LastError) : LearningRate);
+
+					if ( Shuffle )
+						_shuffle( Order, Random );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+					double EpochStart = _startEpoch();
+
+					for ( auto w = Workers.begin(), w_end = Workers.end(); w != w_end; ++w )
+						w->ForwardTime = w->BackwardTime = 0.0;
+#endif
+
+					// Where this cycle's dropout starts from -- Each record mixes in its own number, so chunking doesn't change which neurons are left out
+					const uint64_t CycleSeed = _mix( (uint64_t(Seed) << 32) + CurCycle );
+
+					for ( size_t BatchStart = 0; BatchStart < TrainingSetSize; BatchStart += CurBatchSize )
+					{
+						const size_t BatchEnd = std::min( BatchStart + CurBatchSize, TrainingSetSize );
+						const size_t NumChunks = std::min( NumWorkers, BatchEnd - BatchStart );
+
+						Pool.Run( NumChunks, [&]( size_t chunk )
+							{
+								tWorker &Worker = Workers[ chunk ];
+								size_t First = BatchStart + ((chunk * (BatchEnd - BatchStart)) / NumChunks);
+								size_t Last = BatchStart + (((chunk + 1) * (BatchEnd - BatchStart)) / NumChunks);
+
+								Worker.Error = tNeurotransmitter();
+
+								for ( size_t l = 0; l < NumLayers; ++l )
+								{
+									Worker.Gradient[ l ].assign( Compiled.Layers[l].Weights.size(), tNeurotransmitter() );
+									Worker.BiasGradient[ l ].assign( Compiled.Layers[l].NumNeurons, tNeurotransmitter() );
+								}
+
+								for ( size_t CurRecord = First; CurRecord < Last; ++CurRecord )
+									_backpropagate( Compiled, Worker, Inputs + (Order[CurRecord] * NumIn), Targets + (Order[CurRecord] * NumOut), HasOutput, _mix(CycleSeed + Order[CurRecord]) );
+							} );
+
+						for ( size_t c = 0; c < NumChunks; ++c )
+							SetError += Workers[ c ].Error;
+
+						// Batch training -- the weights are only updated once the entire set has been seen (and only if we aren't already trained)
+						if ( batchSize == 0 )
+						{
+							if ( SetError <= AllowedError )
+								break;
+						}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						auto Mark = ttProfiler::tClock::now();
+#endif
+						_applyUpdates( Compiled, *CurOptimizer, Workers, NumChunks, Gradient, WeightUpdates, CurLearningRate );
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+						_EpochCounters.ApplyTime += _lap( Mark );
+#endif
+					}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+					// Every thread's time, added up
+					for ( auto w = Workers.begin(), w_end = Workers.end(); w != w_end; ++w )
+					{
+						_EpochCounters.ForwardTime += w->ForwardTime;
+						_EpochCounters.BackwardTime += w->BackwardTime;
+					}
+
+					_endEpoch( EpochStart, CurCycle, TrainingSetSize, SetError, CurLearningRate );
+#endif
+
+					if ( SetError <= AllowedError )
+					{
+						Trained = true;
+						break;
+					}
+
+					LastError = (validation ? _validateCompiled(Compiled, BoundValidation, ValidationOutputs) : SetError);
+
+					if ( LastError < BestError )
+					{
+						BestError = LastError;
+						BestCycle = CurCycle;
+
+						if ( validation && RestoreBest )
+							BestLayers = Compiled.Layers;
+					}
+					else if ( Patience != 0 && CurCycle - BestCycle >= Patience )
+						break;
+				}
+
+				if ( !Trained && !BestLayers.empty() )
+					Compiled.Layers = BestLayers;
+
+				Compiled.Export( network );
+
+				if ( numCycles )
+					*numCycles = CurCycle;
+
+				if ( networkError )
+					*networkError = SetError;
+
+				return Trained;
+			}
+
+			// Use the set as-is if it lines up with the network, otherwise lay it out in the network's order once -- Inputs missing from the set keep whatever value the network had
+			void _bindSet( const ttCompiledGanglion &compiled, const ttTrainingSet &set, tBoundSet &bound )
+			{
+				const size_t NumIn = compiled.NumInputs();
+				const size_t NumOut = compiled.NumOutputs();
+				auto Binding = set.Bind( compiled.InputLabels, compiled.OutputLabels );
+
+				bound.Inputs = set.InputData();
+				bound.Targets = set.OutputData();
+				bound.Size = set.Size();
+				bound.HasOutput.assign( NumOut, true );
+
+				if ( Binding.Direct )
+					return;
+
+				bound.BoundInputs.resize( bound.Size * NumIn );
+				bound.BoundTargets.resize( bound.Size * NumOut );
+
+				for ( size_t o = 0; o < NumOut; ++o )
+					bound.HasOutput[ o ] = (Binding.Output[o] != ttTrainingSet::NoColumn);
+
+				for ( size_t CurRecord = 0; CurRecord < bound.Size; ++CurRecord )
+				{
+					auto Record = set.Record( CurRecord );
+
+					for ( size_t i = 0; i < NumIn; ++i )
+						bound.BoundInputs[ (CurRecord * NumIn) + i ] = (Binding.Input[i] != ttTrainingSet::NoColumn ? Record.Input[Binding.Input[i]] : compiled.State.Input[i]);
+
+					for ( size_t o = 0; o < NumOut; ++o )
+						bound.BoundTargets[ (CurRecord * NumOut) + o ] = (bound.HasOutput[o] ? Record.Output[Binding.Output[o]] : tNeurotransmitter());
+				}
+
+				bound.Inputs = bound.BoundInputs.data();
+				bound.Targets = bound.BoundTargets.data();
+			}
+
+			// The compiled equivalent of Validate() -- 'outputs' is just somewhere to put the results
+			tNeurotransmitter _validateCompiled( ttCompiledGanglion &compiled, const tBoundSet &bound, tValues &outputs )
+			{
+				const size_t NumOut = compiled.NumOutputs();
+				tNeurotransmitter SetError = tNeurotransmitter();
+
+				if ( bound.Size == 0 )
+					return SetError;
+
+				compiled.ProcessBatch( bound.Inputs, bound.Size, outputs.data(), MaxProcessingCycles );
+
+				for ( size_t CurRecord = 0; CurRecord < bound.Size; ++CurRecord )
+				{
+					const tNeurotransmitter *Output = outputs.data() + (CurRecord * NumOut);
+					const tNeurotransmitter *Target = bound.Targets + (CurRecord * NumOut);
+					tNeurotransmitter NetworkError = tNeurotransmitter();
+
+					for ( size_t o = 0; o < NumOut; ++o )
+					{
+						if ( bound.HasOutput[o] )
+							NetworkError += _outputError( compiled.SoftmaxOutput, Output[o], Target[o] );
 					}
 
 					SetError += NetworkError;
 				}
 
-				if ( error != NULL )
-					*error = SetError;
+				return SetError;
+			}
 
-				return SetError <= AllowedError;
+			// Runs a single record forward and back through the network, adding its weight gradients to the worker's
+			void _backpropagate( const ttCompiledGanglion &compiled, tWorker &worker, const tNeurotransmitter *input, const tNeurotransmitter *target, const std::vector<unsigned char> &hasOutput, uint64_t dropoutSeed )
+			{
+				typedef typename ttCompiledGanglion::ttNeuron		tTrainedNeuron;
+				auto &State = worker.State;
+				const size_t NumLayers = compiled.Layers.size();
+				const bool UseDropout = (Dropout > tNeurotransmitter());
+				const tNeurotransmitter DropoutScale = tNeurotransmitter(1) / (tNeurotransmitter(1) - Dropout);
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				auto Mark = ttProfiler::tClock::now();
+#endif
+				std::copy( input, input + State.Input.size(), State.Input.begin() );
+
+				if ( !UseDropout )
+					compiled.Process( State, MaxProcessingCycles );
+				else
+				{
+					// A layer at a time, leaving out hidden neurons as we go (and scaling up the rest, so the next layer sees the same total on average)
+					for ( size_t l = 0; l < NumLayers; ++l )
+					{
+						compiled.ProcessLayer( State, l );
+
+						if ( l + 1 == NumLayers )
+							break;
+
+						tValues &Value = State.Value[ l ];
+						std::vector< unsigned char > &Kept = worker.Kept[ l ];
+
+						for ( size_t h = 0, h_end = Value.size(); h < h_end; ++h )
+						{
+							double Chance = double( _mix(dropoutSeed + (uint64_t(l) << 32) + h) >> 11 ) * (1.0 / 9007199254740992.0);
+
+							Kept[ h ] = (Chance >= double(Dropout));
+							Value[ h ] = (Kept[h] ? Value[h] * DropoutScale : tNeurotransmitter());
+						}
+					}
+				}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				worker.ForwardTime += _lap( Mark );
+#endif
+
+				// Output errors
+				{
+					const tValues &Output = State.Value.back();
+					tValues &Delta = worker.Delta.back();
+
+					if ( compiled.SoftmaxOutput )
+					{
+						// Cross-entropy through the softmax, differentiated together -- Comes out to (output - target) for each output's sum, with no derivative to take (targets the set doesn't have are 0)
+						for ( size_t o = 0, o_end = Output.size(); o < o_end; ++o )
+						{
+							if ( hasOutput[o] )
+								worker.Error += Default::ErrorFunc::CrossEntropy( target[o], Output[o] );
+
+							Delta[ o ] = Output[ o ] - target[ o ];
+						}
+					}
+					else
+					{
+						tTrainedNeuron::DeriveLayer( Output.data(), Delta.data(), Output.size() );
+
+						for ( size_t o = 0, o_end = Output.size(); o < o_end; ++o )
+						{
+							if ( !hasOutput[o] )
+							{
+								Delta[ o ] = tNeurotransmitter();
+								continue;
+							}
+
+							tNeurotransmitter Error = Output[o] - target[o];
+							worker.Error += this->CalculateError( Error );
+							Delta[ o ] *= Error;
+						}
+					}
+				}
+
+				// Work backwards through the hidden layers -- Each neuron's error is the weighted sum of the errors of the layer after it
+				for ( size_t l = NumLayers - 1; l > 0; --l )
+				{
+					const auto &NextLayer = compiled.Layers[ l ];
+					const tValues &NextDelta = worker.Delta[ l ];
+					const tValues &Value = State.Value[ l - 1 ];
+					tValues &Delta = worker.Delta[ l - 1 ];
+
+					std::fill( Delta.begin(), Delta.end(), tNeurotransmitter() );
+
+					const tNeurotransmitter *Weight = NextLayer.Weights.data();
+
+					for ( size_t n = 0; n < NextLayer.NumNeurons; ++n, Weight += NextLayer.NumInputs )
+					{
+						tNeurotransmitter CurDelta = NextDelta[ n ];
+
+						for ( size_t h = 0; h < NextLayer.NumInputs; ++h )
+							Delta[ h ] += CurDelta * Weight[ h ];
+					}
+
+					if ( !UseDropout )
+					{
+						for ( size_t h = 0, h_end = Delta.size(); h < h_end; ++h )
+							Delta[ h ] *= tTrainedNeuron::Derive( Value[h] );
+					}
+					else
+					{
+						// Neurons left out didn't contribute anything, and the rest were scaled up (so derive their values from before that)
+						const std::vector< unsigned char > &Kept = worker.Kept[ l - 1 ];
+
+						for ( size_t h = 0, h_end = Delta.size(); h < h_end; ++h )
+							Delta[ h ] = (Kept[h] ? Delta[h] * DropoutScale * tTrainedNeuron::Derive(Value[h] / DropoutScale) : tNeurotransmitter());
+					}
+				}
+
+				// And finally, the gradients themselves
+				for ( size_t l = 0; l < NumLayers; ++l )
+				{
+					const auto &CurLayer = compiled.Layers[ l ];
+					const tNeurotransmitter *Prev = (l == 0 ? State.Input.data() : State.Value[l - 1].data());
+					const tValues &Delta = worker.Delta[ l ];
+					tNeurotransmitter *Gradient = worker.Gradient[ l ].data();
+
+					for ( size_t n = 0; n < CurLayer.NumNeurons; ++n, Gradient += CurLayer.NumInputs )
+					{
+						tNeurotransmitter CurDelta = Delta[ n ];
+
+						for ( size_t i = 0; i < CurLayer.NumInputs; ++i )
+							Gradient[ i ] += CurDelta * Prev[ i ];
+
+						worker.BiasGradient[ l ][ n ] += CurDelta * compiled.BiasValue;
+					}
+				}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+				worker.BackwardTime += _lap( Mark );
+#endif
+			}
+
+			// Adds up the gradients from each chunk (in order) and updates the weights that exist in the network
+			void _applyUpdates( ttCompiledGanglion &compiled, ttOptimizer &optimizer, const std::vector<tWorker> &workers, size_t numChunks, tValues &gradient, tValues &weightUpdates, tNeurotransmitter learningRate )
+			{
+				const bool Regularized = _regularized();
+				const tNeurotransmitter Decay = learningRate * WeightDecay;
+				size_t First = 0;
+
+				optimizer.NewUpdate();
+
+				for ( size_t l = 0, l_end = compiled.Layers.size(); l < l_end; ++l )
+				{
+					auto &CurLayer = compiled.Layers[ l ];
+					const size_t NumWeights = CurLayer.Weights.size();
+					const size_t NumNeurons = CurLayer.NumNeurons;
+
+					// Weights that aren't in the network always stay at zero
+					for ( size_t w = 0; w < NumWeights; ++w )
+					{
+						tNeurotransmitter Sum = tNeurotransmitter();
+
+						if ( CurLayer.Connected[w] )
+						{
+							for ( size_t c = 0; c < numChunks; ++c )
+								Sum += workers[ c ].Gradient[ l ][ w ];
+
+							if ( Regularized )
+								Sum += _penalty( CurLayer.Weights[w] );
+						}
+
+						gradient[ First + w ] = Sum;
+					}
+
+					for ( size_t n = 0; n < NumNeurons; ++n )
+					{
+						tNeurotransmitter Sum = tNeurotransmitter();
+
+						if ( CurLayer.BiasConnected[n] )
+						{
+							for ( size_t c = 0; c < numChunks; ++c )
+								Sum += workers[ c ].BiasGradient[ l ][ n ];
+						}
+
+						gradient[ First + NumWeights + n ] = Sum;
+					}
+
+					optimizer.Step( &gradient[First], &weightUpdates[First], First, NumWeights + NumNeurons, learningRate );
+
+					for ( size_t w = 0; w < NumWeights; ++w )
+					{
+						if ( CurLayer.Connected[w] )
+							CurLayer.Weights[ w ] += weightUpdates[ First + w ] - (Decay * CurLayer.Weights[w]);
+					}
+
+					for ( size_t n = 0; n < NumNeurons; ++n )
+					{
+						if ( CurLayer.BiasConnected[n] )
+							CurLayer.Bias[ n ] += weightUpdates[ First + NumWeights + n ];
+					}
+
+#if defined(TOOLBOX_NEURALNETWORK_PROFILE)
+					_countUpdates( &weightUpdates[First], NumWeights, CurLayer.Connected.data() );
+					_countUpdates( &weightUpdates[First + NumWeights], NumNeurons, CurLayer.BiasConnected.data() );
+#endif
+
+					First += NumWeights + NumNeurons;
+				}
 			}
 		};
 
-		typedef tTrainer<>			Trainer;
+		typedef tTrainer<>					Trainer;
+		typedef tTrainer< FloatGanglion >	FloatTrainer;
 	}
 }
 
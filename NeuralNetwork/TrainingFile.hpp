@@ -0,0 +1,444 @@
+#ifndef TOOLBOX_NEURALNETWORK_TRAININGFILE_HPP
+#define TOOLBOX_NEURALNETWORK_TRAININGFILE_HPP
+
+/*
+ * Toolbox/NeuralNetwork/TrainingFile.hpp
+ *
+ * A compact binary file format for training sets, and a writer to stream
+ * records into one.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - Everything in the file is little-endian.  The layout is:
+ *
+ *     Offset  Size  Contents
+ *     0       8     "TBNNDATA"
+ *     8       4     Format version (currently 1)
+ *     12      4     Value type (1 = 32-bit float, 2 = 64-bit double)
+ *     16      8     Number of records
+ *     24      4     Number of input columns
+ *     28      4     Number of output columns
+ *     32      8     Offset of the data (always a multiple of 64)
+ *     40      ...   Input labels, then output labels -- Each is a 4-byte
+ *                   length followed by that many characters
+ *
+ *   The data is the input matrix followed by the output matrix, each
+ *   row-major (one row per record) with the columns sorted by label.
+ *
+ * - This is the same layout tTrainingSet<> uses in memory, so a file with
+ *   the right value type can be opened (see tTrainingSet<>::Open()) and used
+ *   directly, without reading or converting anything.
+ *
+ * - tTrainingFileWriter<> streams records straight to disk, so sets far too
+ *   large to build in memory can still be written.  The outputs are held in
+ *   a temporary file (<fileName>.outputs) until Close(), which appends them
+ *   and fills in the record count.
+ *
+ ****************************************************************************
+	// Columns can be given in any order -- Records are written in that order
+	Toolbox::NeuralNetwork::tTrainingFileWriter< double > Writer( "xor.dat", { "Input 1", "Input 2" }, { "Output" } );
+
+	double Input[] = { 1.0, 0.0 };
+	double Output[] = { 1.0 };
+	Writer.AddRecord( Input, Output );
+	// ...
+
+	Writer.Close();
+
+	// Then, later (and as often as needed)
+	Toolbox::NeuralNetwork::TrainingSet Set;
+	Set.Open( "xor.dat" );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <Toolbox/NeuralNetwork/Neuron.hpp>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		namespace TrainingFile
+		{
+			const char			Magic[ 8 ]		= { 'T', 'B', 'N', 'N', 'D', 'A', 'T', 'A' };
+			const uint32_t		Version			= 1;
+			const size_t		DataAlignment	= 64;
+			const size_t		HeaderSize		= 40;	// Everything before the labels
+
+			enum tValueType
+			{
+				Float			= 1,
+				Double			= 2
+			};
+
+			template <typename tType>
+			uint32_t ValueType()
+			{
+				static_assert( std::is_same<tType, float>::value || std::is_same<tType, double>::value, "Training files can only hold float or double values." );
+				return std::is_same<tType, float>::value ? Float : Double;
+			}
+
+			inline size_t ValueSize( uint32_t valueType )
+			{
+				if ( valueType == Float )
+					return sizeof( float );
+
+				if ( valueType == Double )
+					return sizeof( double );
+
+				throw std::runtime_error( "Toolbox::NeuralNetwork::TrainingFile::ValueSize(): Unknown value type." );
+			}
+
+			inline bool LittleEndian()
+			{
+				const uint16_t Test = 1;
+				unsigned char FirstByte = 0;
+				std::memcpy( &FirstByte, &Test, 1 );
+				return FirstByte == 1;
+			}
+
+			// Reads an unsigned little-endian value of 'size' bytes
+			inline uint64_t Read( const unsigned char *data, size_t size )
+			{
+				uint64_t Value = 0;
+
+				for ( size_t b = size; b > 0; --b )
+					Value = (Value << 8) | data[ b - 1 ];
+
+				return Value;
+			}
+
+			inline void Write( std::ostream &stream, uint64_t value, size_t size )
+			{
+				for ( size_t b = 0; b < size; ++b, value >>= 8 )
+					stream.put( char(value & 0xFF) );
+			}
+
+			// Writes values in little-endian order, whatever our own order is
+			template <typename tType>
+			void WriteValues( std::ostream &stream, const tType *values, size_t count )
+			{
+				if ( LittleEndian() )
+				{
+					stream.write( reinterpret_cast<const char *>(values), std::streamsize(count * sizeof(tType)) );
+					return;
+				}
+
+				for ( size_t v = 0; v < count; ++v )
+				{
+					char Bytes[ sizeof(tType) ];
+					std::memcpy( Bytes, &values[v], sizeof(tType) );
+					std::reverse( Bytes, Bytes + sizeof(tType) );
+					stream.write( Bytes, sizeof(tType) );
+				}
+			}
+
+			// Reads one value of the given type, converting it to our own type
+			template <typename tType>
+			tType ReadValue( const unsigned char *data, uint32_t valueType )
+			{
+				unsigned char Bytes[ sizeof(double) ];
+				size_t Size = ValueSize( valueType );
+
+				std::memcpy( Bytes, data, Size );
+
+				if ( !LittleEndian() )
+					std::reverse( Bytes, Bytes + Size );
+
+				if ( valueType == Float )
+				{
+					float Value;
+					std::memcpy( &Value, Bytes, sizeof(float) );
+					return tType( Value );
+				}
+
+				double Value;
+				std::memcpy( &Value, Bytes, sizeof(double) );
+				return tType( Value );
+			}
+
+			struct tHeader
+			{
+				uint32_t					Version;
+				uint32_t					ValueType;
+				uint64_t					NumRecords;
+				std::vector< std::string >	InputLabels;
+				std::vector< std::string >	OutputLabels;
+				uint64_t					DataOffset;
+
+				// Where the output matrix starts
+				uint64_t OutputOffset() const
+				{
+					return DataOffset + (NumRecords * InputLabels.size() * ValueSize(ValueType));
+				}
+
+				// Where the file should end
+				uint64_t EndOffset() const
+				{
+					return OutputOffset() + (NumRecords * OutputLabels.size() * ValueSize(ValueType));
+				}
+			};
+
+			inline void WriteHeader( std::ostream &stream, const tHeader &header )
+			{
+				stream.write( Magic, sizeof(Magic) );
+				Write( stream, header.Version, 4 );
+				Write( stream, header.ValueType, 4 );
+				Write( stream, header.NumRecords, 8 );
+				Write( stream, header.InputLabels.size(), 4 );
+				Write( stream, header.OutputLabels.size(), 4 );
+				Write( stream, header.DataOffset, 8 );
+
+				for ( auto i = header.InputLabels.begin(), i_end = header.InputLabels.end(); i != i_end; ++i )
+				{
+					Write( stream, i->size(), 4 );
+					stream.write( i->data(), std::streamsize(i->size()) );
+				}
+
+				for ( auto o = header.OutputLabels.begin(), o_end = header.OutputLabels.end(); o != o_end; ++o )
+				{
+					Write( stream, o->size(), 4 );
+					stream.write( o->data(), std::streamsize(o->size()) );
+				}
+			}
+
+			// How much room a header (with these labels) takes up, including the padding before the data
+			inline uint64_t DataOffset( const std::vector<std::string> &inputLabels, const std::vector<std::string> &outputLabels )
+			{
+				uint64_t Size = HeaderSize;
+
+				for ( auto i = inputLabels.begin(), i_end = inputLabels.end(); i != i_end; ++i )
+					Size += 4 + i->size();
+
+				for ( auto o = outputLabels.begin(), o_end = outputLabels.end(); o != o_end; ++o )
+					Size += 4 + o->size();
+
+				return ((Size + DataAlignment - 1) / DataAlignment) * DataAlignment;
+			}
+
+			inline void ReadHeader( const unsigned char *data, size_t size, tHeader &header )
+			{
+				if ( size < HeaderSize || std::memcmp(data, Magic, sizeof(Magic)) != 0 )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::TrainingFile::ReadHeader(): Not a training file." );
+
+				header.Version = uint32_t( Read(data + 8, 4) );
+				header.ValueType = uint32_t( Read(data + 12, 4) );
+				header.NumRecords = Read( data + 16, 8 );
+				size_t NumInputs = size_t( Read(data + 24, 4) );
+				size_t NumOutputs = size_t( Read(data + 28, 4) );
+				header.DataOffset = Read( data + 32, 8 );
+
+				if ( header.Version != Version )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::TrainingFile::ReadHeader(): Unsupported training file version." );
+
+				ValueSize( header.ValueType );		// Throws if it isn't one we know
+
+				size_t Offset = HeaderSize;
+				header.InputLabels.clear();
+				header.OutputLabels.clear();
+
+				for ( size_t l = 0; l < NumInputs + NumOutputs; ++l )
+				{
+					if ( Offset + 4 > size )
+						throw std::runtime_error( "Toolbox::NeuralNetwork::TrainingFile::ReadHeader(): Training file is truncated." );
+
+					size_t Length = size_t( Read(data + Offset, 4) );
+					Offset += 4;
+
+					if ( Offset + Length > size )
+						throw std::runtime_error( "Toolbox::NeuralNetwork::TrainingFile::ReadHeader(): Training file is truncated." );
+
+					std::string Label( reinterpret_cast<const char *>(data + Offset), Length );
+					Offset += Length;
+
+					if ( l < NumInputs )
+						header.InputLabels.push_back( Label );
+					else
+						header.OutputLabels.push_back( Label );
+				}
+
+				if ( header.DataOffset < Offset || header.DataOffset > size )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::TrainingFile::ReadHeader(): Training file is truncated." );
+
+				// NumRecords comes straight from the file, so don't multiply it (the offsets could wrap around)
+				uint64_t RecordSize = uint64_t(NumInputs + NumOutputs) * ValueSize( header.ValueType );
+
+				if ( RecordSize > 0 && header.NumRecords > (size - header.DataOffset) / RecordSize )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::TrainingFile::ReadHeader(): Training file is truncated." );
+			}
+		}
+
+
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter>
+		class tTrainingFileWriter
+		{
+		public:
+			typedef _tNeurotransmitter						tNeurotransmitter;
+			typedef std::vector< std::string >				tLabels;
+
+			TOOLBOX_POINTERS( tTrainingFileWriter<tNeurotransmitter> )
+
+		public:
+			// Records passed to AddRecord() have their columns in the order given here
+			tTrainingFileWriter( const std::string &fileName, const tLabels &inputLabels, const tLabels &outputLabels ):
+				_FileName( fileName ),
+				_InputOrder( _sortedOrder(inputLabels) ),
+				_OutputOrder( _sortedOrder(outputLabels) )
+			{
+				_Header.Version = TrainingFile::Version;
+				_Header.ValueType = TrainingFile::ValueType< tNeurotransmitter >();
+				_Header.NumRecords = 0;
+
+				for ( auto i = _InputOrder.begin(), i_end = _InputOrder.end(); i != i_end; ++i )
+					_Header.InputLabels.push_back( inputLabels[*i] );
+
+				for ( auto o = _OutputOrder.begin(), o_end = _OutputOrder.end(); o != o_end; ++o )
+					_Header.OutputLabels.push_back( outputLabels[*o] );
+
+				_Header.DataOffset = TrainingFile::DataOffset( _Header.InputLabels, _Header.OutputLabels );
+
+				_File.open( fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+				_Outputs.open( _outputsFileName().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+
+				if ( !_File || !_Outputs )
+					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tTrainingFileWriter<>::tTrainingFileWriter(): Unable to create '") + fileName + std::string("'.") );
+
+				// The record count is filled in by Close()
+				TrainingFile::WriteHeader( _File, _Header );
+
+				for ( uint64_t Pad = uint64_t(_File.tellp()); Pad < _Header.DataOffset; ++Pad )
+					_File.put( 0 );
+
+				_InputRow.resize( _InputOrder.size() );
+				_OutputRow.resize( _OutputOrder.size() );
+			}
+
+			virtual ~tTrainingFileWriter()
+			{
+				// Can't throw from here, so anything going wrong just leaves an incomplete file
+				try
+				{
+					Close();
+				}
+				catch ( ... )
+				{
+				}
+			}
+
+			size_t Size() const
+			{
+				return size_t( _Header.NumRecords );
+			}
+
+			void AddRecord( const tNeurotransmitter *input, const tNeurotransmitter *output )
+			{
+				if ( !_File.is_open() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tTrainingFileWriter<>::AddRecord(): File has already been closed." );
+
+				for ( size_t i = 0, i_end = _InputOrder.size(); i < i_end; ++i )
+					_InputRow[ i ] = input[ _InputOrder[i] ];
+
+				for ( size_t o = 0, o_end = _OutputOrder.size(); o < o_end; ++o )
+					_OutputRow[ o ] = output[ _OutputOrder[o] ];
+
+				TrainingFile::WriteValues( _File, _InputRow.data(), _InputRow.size() );
+				TrainingFile::WriteValues( _Outputs, _OutputRow.data(), _OutputRow.size() );
+
+				++_Header.NumRecords;
+			}
+
+			void AddRecord( const std::vector<tNeurotransmitter> &input, const std::vector<tNeurotransmitter> &output )
+			{
+				if ( input.size() != _InputOrder.size() || output.size() != _OutputOrder.size() )
+					throw std::runtime_error( "Toolbox::NeuralNetwork::tTrainingFileWriter<>::AddRecord(): Wrong number of columns." );
+
+				AddRecord( input.data(), output.data() );
+			}
+
+			// Finishes the file -- Nothing can be added afterwards
+			void Close()
+			{
+				if ( !_File.is_open() )
+					return;
+
+				// Move the outputs over
+				_Outputs.close();
+
+				std::ifstream Outputs( _outputsFileName().c_str(), std::ios::in | std::ios::binary );
+				char Buffer[ 65536 ];
+
+				while ( Outputs.read(Buffer, sizeof(Buffer)) || Outputs.gcount() > 0 )
+					_File.write( Buffer, Outputs.gcount() );
+
+				Outputs.close();
+				std::remove( _outputsFileName().c_str() );
+
+				// And now that we know how many records there are
+				_File.seekp( 16 );
+				TrainingFile::Write( _File, _Header.NumRecords, 8 );
+
+				bool Good = bool( _File );
+				_File.close();
+
+				if ( !Good )
+					throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tTrainingFileWriter<>::Close(): Unable to write '") + _FileName + std::string("'.") );
+			}
+
+		protected:
+			std::string						_FileName;
+			std::vector< size_t >			_InputOrder;	// Which of the caller's columns goes in each of our (sorted) columns
+			std::vector< size_t >			_OutputOrder;
+			TrainingFile::tHeader			_Header;
+			std::ofstream					_File;
+			std::ofstream					_Outputs;
+			std::vector< tNeurotransmitter >	_InputRow;
+			std::vector< tNeurotransmitter >	_OutputRow;
+
+		protected:
+			std::string _outputsFileName() const
+			{
+				return _FileName + std::string( ".outputs" );
+			}
+
+			static std::vector< size_t > _sortedOrder( const tLabels &labels )
+			{
+				std::vector< size_t > Order( labels.size() );
+
+				for ( size_t l = 0, l_end = labels.size(); l < l_end; ++l )
+					Order[ l ] = l;
+
+				std::sort( Order.begin(), Order.end(), [&labels]( size_t a, size_t b ) { return labels[a] < labels[b]; } );
+
+				for ( size_t l = 1, l_end = Order.size(); l < l_end; ++l )
+				{
+					if ( labels[Order[l - 1]] == labels[Order[l]] )
+						throw std::runtime_error( std::string("Toolbox::NeuralNetwork::tTrainingFileWriter<>::tTrainingFileWriter(): Column '") + labels[Order[l]] + std::string("' was given more than once.") );
+				}
+
+				return Order;
+			}
+		};
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_TRAININGFILE_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
@@ -0,0 +1,763 @@
+#ifndef TOOLBOX_NEURALNETWORK_VECTORIZED_HPP
+#define TOOLBOX_NEURALNETWORK_VECTORIZED_HPP
+
+/*
+ * Toolbox/NeuralNetwork/Vectorized.hpp
+ *
+ * Batch (SIMD) versions of the default activation and derivation functions.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - Each of the default Activation/Derivation functions from Neuron.hpp gets
+ *   a batch version here that works on an entire array of values at once:
+ *
+ *       Activation::Sigmoid( const T *values, T *result, size_t count, bool fastExp = false )
+ *
+ *   'values' and 'result' may be the same array.
+ *
+ * - float and double arrays use AVX2 (when compiled with -mavx2, and FMA
+ *   when compiled with -mfma) or SSE2, falling back to plain scalar code
+ *   everywhere else.  Any other tNeurotransmitter type simply loops over the
+ *   scalar functions.  Define TOOLBOX_NEURALNETWORK_NO_SIMD to force the
+ *   scalar versions.
+ *
+ * - The vector code uses its own polynomial exp() that is accurate to about
+ *   an ulp, so results can differ from the scalar functions in the last
+ *   digit.  Passing fastExp = true switches to a much shorter polynomial
+ *   (relative error around 4e-5) for when speed matters more than accuracy.
+ *   Without AVX2, precise double kernels stick with the library exp(), since
+ *   two SSE2 lanes can't outrun it.
+ *
+ * - tVectorizedNucleus<> is a drop-in nucleus whose ActivateLayer() and
+ *   DeriveLayer() use these kernels, so flattened networks (see Compiled.hpp)
+ *   activate a whole layer in a single call.  Which function it uses is a
+ *   template parameter (SigmoidKernel by default, or FastSigmoidKernel or
+ *   TanHKernel), and that same kernel supplies its per-neuron Activation()
+ *   and Derivation() -- So the neuron graph and the flattened networks always
+ *   agree.  The class is final; for any other activation function, derive
+ *   from tNucleus<> and override all four functions together.
+ *
+ ****************************************************************************
+	typedef Toolbox::NeuralNetwork::tNeuron< Toolbox::NeuralNetwork::VectorizedNucleus >	Neuron;
+	typedef Toolbox::NeuralNetwork::tGanglion< Neuron >										Ganglion;
+
+	// Optionally trade some accuracy for speed
+	Neuron::Nucleus.FastExp = true;
+
+	// Or pick another activation function (for the graph and the layer functions alike)
+	typedef Toolbox::NeuralNetwork::tVectorizedNucleus< double, Toolbox::NeuralNetwork::TanHKernel >	TanHNucleus;
+
+	// Or use the kernels directly
+	std::vector< double > Values( 1024 );
+	Toolbox::NeuralNetwork::Activation::Sigmoid( Values.data(), Values.data(), Values.size() );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <Toolbox/NeuralNetwork/Neuron.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+#if !defined(TOOLBOX_NEURALNETWORK_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+	#define TOOLBOX_NEURALNETWORK_SIMD		1
+	#include <immintrin.h>
+#endif
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		namespace SIMD
+		{
+			// Polynomial degrees used by our exp() approximation
+			template <typename tType>
+			struct tExpDegree
+			{
+				static const int	Precise		= 13;
+				static const int	Fast		= 4;
+			};
+
+			template <>
+			struct tExpDegree< float >
+			{
+				static const int	Precise		= 7;
+				static const int	Fast		= 4;
+			};
+
+			// Whether our precise exp() polynomial is worth vectorizing (two SSE2 lanes of double can't beat the library exp())
+			template <typename tType>
+			struct tPreciseVector
+			{
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+				static const bool	Value		= true;
+#else
+				static const bool	Value		= false;
+#endif
+			};
+
+#if !defined(__AVX2__)
+			template <>
+			struct tPreciseVector< double >
+			{
+				static const bool	Value		= false;
+			};
+#endif
+
+			// Range limits and constants for our exp() approximation (Cephes-style range reduction)
+			template <typename tType>
+			struct tExpConstants
+			{
+				static constexpr tType	Min			= tType(-708.0);
+				static constexpr tType	Max			= tType(709.0);
+				static constexpr tType	Log2e		= tType(1.4426950408889634);
+				static constexpr tType	Ln2Hi		= tType(6.93145751953125E-1);
+				static constexpr tType	Ln2Lo		= tType(1.42860682030941723212E-6);
+			};
+
+			template <>
+			struct tExpConstants< float >
+			{
+				static constexpr float	Min			= -87.0f;
+				static constexpr float	Max			= 88.0f;
+				static constexpr float	Log2e		= 1.44269504f;
+				static constexpr float	Ln2Hi		= 0.693359375f;
+				static constexpr float	Ln2Lo		= -2.12194440e-4f;
+			};
+
+			// Taylor coefficients (1/k!) for our exp() polynomial
+			template <typename tType>
+			struct tExpCoefficients
+			{
+				static constexpr tType	Value[ 14 ] =
+				{
+					tType(1.0), tType(1.0), tType(1.0 / 2.0), tType(1.0 / 6.0), tType(1.0 / 24.0), tType(1.0 / 120.0), tType(1.0 / 720.0),
+					tType(1.0 / 5040.0), tType(1.0 / 40320.0), tType(1.0 / 362880.0), tType(1.0 / 3628800.0), tType(1.0 / 39916800.0),
+					tType(1.0 / 479001600.0), tType(1.0 / 6227020800.0)
+				};
+			};
+
+			// The scalar version of our vector exp() -- Used for the leftovers at the end of an array so results don't depend on position
+			template <typename tType, int Degree>
+			tType Exp( tType value )
+			{
+				typedef tExpConstants< tType >	C;
+
+				// NaN goes straight through, like std::exp() (and casting it to an int below would be undefined)
+				if ( value != value )
+					return value;
+
+				value = std::min( std::max(value, C::Min), C::Max );
+
+				tType n = std::nearbyint( value * C::Log2e );
+				tType r = value - (n * C::Ln2Hi) - (n * C::Ln2Lo);
+				tType p = tExpCoefficients<tType>::Value[ Degree ];
+
+				for ( int k = Degree - 1; k >= 0; --k )
+					p = (p * r) + tExpCoefficients<tType>::Value[ k ];
+
+				return std::ldexp( p, static_cast<int>(n) );
+			}
+
+			template <typename tType>
+			tType Exp( tType value, bool fastExp )
+			{
+				if ( fastExp )
+					return Exp< tType, tExpDegree<tType>::Fast >( value );
+
+				if ( tPreciseVector<tType>::Value )
+					return Exp< tType, tExpDegree<tType>::Precise >( value );
+
+				return std::exp( value );
+			}
+
+
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+			// Instruction set wrappers, so each kernel only needs to be written once
+			template <typename tType, typename tISA> struct tVector;
+
+			struct SSE2 {};
+			struct AVX2 {};
+
+			template <>
+			struct tVector< double, SSE2 >
+			{
+				typedef __m128d		tType;
+				static const size_t	Width = 2;
+
+				static tType Load( const double *v )				{ return _mm_loadu_pd( v ); }
+				static void Store( double *v, tType a )				{ _mm_storeu_pd( v, a ); }
+				static tType Set( double v )						{ return _mm_set1_pd( v ); }
+				static tType Add( tType a, tType b )				{ return _mm_add_pd( a, b ); }
+				static tType Sub( tType a, tType b )				{ return _mm_sub_pd( a, b ); }
+				static tType Mul( tType a, tType b )				{ return _mm_mul_pd( a, b ); }
+				static tType Div( tType a, tType b )				{ return _mm_div_pd( a, b ); }
+				static tType MulAdd( tType a, tType b, tType c )	{ return _mm_add_pd( _mm_mul_pd(a, b), c ); }
+				static tType Min( tType a, tType b )				{ return _mm_min_pd( a, b ); }
+				static tType Max( tType a, tType b )				{ return _mm_max_pd( a, b ); }
+				static tType SignBits( tType a )					{ return _mm_and_pd( a, _mm_set1_pd(-0.0) ); }
+				static tType Abs( tType a )							{ return _mm_andnot_pd( _mm_set1_pd(-0.0), a ); }
+				static tType Xor( tType a, tType b )				{ return _mm_xor_pd( a, b ); }
+
+				// Rounds to the nearest integer, and returns 2^n for the same value
+				static tType Round( tType a, tType &pow2n )
+				{
+					__m128i n = _mm_cvtpd_epi32( a );
+					__m128i e = _mm_add_epi32( n, _mm_set1_epi32(1023) );
+					e = _mm_unpacklo_epi32( e, _mm_setzero_si128() );
+					pow2n = _mm_castsi128_pd( _mm_slli_epi64(e, 52) );
+					return _mm_cvtepi32_pd( n );
+				}
+			};
+
+			template <>
+			struct tVector< float, SSE2 >
+			{
+				typedef __m128		tType;
+				static const size_t	Width = 4;
+
+				static tType Load( const float *v )					{ return _mm_loadu_ps( v ); }
+				static void Store( float *v, tType a )				{ _mm_storeu_ps( v, a ); }
+				static tType Set( float v )							{ return _mm_set1_ps( v ); }
+				static tType Add( tType a, tType b )				{ return _mm_add_ps( a, b ); }
+				static tType Sub( tType a, tType b )				{ return _mm_sub_ps( a, b ); }
+				static tType Mul( tType a, tType b )				{ return _mm_mul_ps( a, b ); }
+				static tType Div( tType a, tType b )				{ return _mm_div_ps( a, b ); }
+				static tType MulAdd( tType a, tType b, tType c )	{ return _mm_add_ps( _mm_mul_ps(a, b), c ); }
+				static tType Min( tType a, tType b )				{ return _mm_min_ps( a, b ); }
+				static tType Max( tType a, tType b )				{ return _mm_max_ps( a, b ); }
+				static tType SignBits( tType a )					{ return _mm_and_ps( a, _mm_set1_ps(-0.0f) ); }
+				static tType Abs( tType a )							{ return _mm_andnot_ps( _mm_set1_ps(-0.0f), a ); }
+				static tType Xor( tType a, tType b )				{ return _mm_xor_ps( a, b ); }
+
+				static tType Round( tType a, tType &pow2n )
+				{
+					__m128i n = _mm_cvtps_epi32( a );
+					__m128i e = _mm_add_epi32( n, _mm_set1_epi32(127) );
+					pow2n = _mm_castsi128_ps( _mm_slli_epi32(e, 23) );
+					return _mm_cvtepi32_ps( n );
+				}
+			};
+
+	#if defined(__AVX2__)
+			template <>
+			struct tVector< double, AVX2 >
+			{
+				typedef __m256d		tType;
+				static const size_t	Width = 4;
+
+				static tType Load( const double *v )				{ return _mm256_loadu_pd( v ); }
+				static void Store( double *v, tType a )				{ _mm256_storeu_pd( v, a ); }
+				static tType Set( double v )						{ return _mm256_set1_pd( v ); }
+				static tType Add( tType a, tType b )				{ return _mm256_add_pd( a, b ); }
+				static tType Sub( tType a, tType b )				{ return _mm256_sub_pd( a, b ); }
+				static tType Mul( tType a, tType b )				{ return _mm256_mul_pd( a, b ); }
+				static tType Div( tType a, tType b )				{ return _mm256_div_pd( a, b ); }
+		#if defined(__FMA__)
+				static tType MulAdd( tType a, tType b, tType c )	{ return _mm256_fmadd_pd( a, b, c ); }
+		#else
+				static tType MulAdd( tType a, tType b, tType c )	{ return _mm256_add_pd( _mm256_mul_pd(a, b), c ); }
+		#endif
+				static tType Min( tType a, tType b )				{ return _mm256_min_pd( a, b ); }
+				static tType Max( tType a, tType b )				{ return _mm256_max_pd( a, b ); }
+				static tType SignBits( tType a )					{ return _mm256_and_pd( a, _mm256_set1_pd(-0.0) ); }
+				static tType Abs( tType a )							{ return _mm256_andnot_pd( _mm256_set1_pd(-0.0), a ); }
+				static tType Xor( tType a, tType b )				{ return _mm256_xor_pd( a, b ); }
+
+				static tType Round( tType a, tType &pow2n )
+				{
+					__m128i n = _mm256_cvtpd_epi32( a );
+					__m256i e = _mm256_cvtepi32_epi64( _mm_add_epi32(n, _mm_set1_epi32(1023)) );
+					pow2n = _mm256_castsi256_pd( _mm256_slli_epi64(e, 52) );
+					return _mm256_cvtepi32_pd( n );
+				}
+			};
+
+			template <>
+			struct tVector< float, AVX2 >
+			{
+				typedef __m256		tType;
+				static const size_t	Width = 8;
+
+				static tType Load( const float *v )					{ return _mm256_loadu_ps( v ); }
+				static void Store( float *v, tType a )				{ _mm256_storeu_ps( v, a ); }
+				static tType Set( float v )							{ return _mm256_set1_ps( v ); }
+				static tType Add( tType a, tType b )				{ return _mm256_add_ps( a, b ); }
+				static tType Sub( tType a, tType b )				{ return _mm256_sub_ps( a, b ); }
+				static tType Mul( tType a, tType b )				{ return _mm256_mul_ps( a, b ); }
+				static tType Div( tType a, tType b )				{ return _mm256_div_ps( a, b ); }
+		#if defined(__FMA__)
+				static tType MulAdd( tType a, tType b, tType c )	{ return _mm256_fmadd_ps( a, b, c ); }
+		#else
+				static tType MulAdd( tType a, tType b, tType c )	{ return _mm256_add_ps( _mm256_mul_ps(a, b), c ); }
+		#endif
+				static tType Min( tType a, tType b )				{ return _mm256_min_ps( a, b ); }
+				static tType Max( tType a, tType b )				{ return _mm256_max_ps( a, b ); }
+				static tType SignBits( tType a )					{ return _mm256_and_ps( a, _mm256_set1_ps(-0.0f) ); }
+				static tType Abs( tType a )							{ return _mm256_andnot_ps( _mm256_set1_ps(-0.0f), a ); }
+				static tType Xor( tType a, tType b )				{ return _mm256_xor_ps( a, b ); }
+
+				static tType Round( tType a, tType &pow2n )
+				{
+					__m256i n = _mm256_cvtps_epi32( a );
+					__m256i e = _mm256_add_epi32( n, _mm256_set1_epi32(127) );
+					pow2n = _mm256_castsi256_ps( _mm256_slli_epi32(e, 23) );
+					return _mm256_cvtepi32_ps( n );
+				}
+			};
+
+			typedef AVX2	tBestISA;
+	#else
+			typedef SSE2	tBestISA;
+	#endif
+
+			// The vector version of Exp() above
+			template <typename tType, typename tISA, int Degree>
+			typename tVector<tType, tISA>::tType Exp( typename tVector<tType, tISA>::tType value )
+			{
+				typedef tVector< tType, tISA >	V;
+				typedef tExpConstants< tType >	C;
+
+				// The bounds go first so NaN lanes stay NaN (min/max return their second operand for those), matching the scalar version
+				value = V::Min( V::Set(C::Max), V::Max(V::Set(C::Min), value) );
+
+				typename V::tType Pow2n;
+				typename V::tType n = V::Round( V::Mul(value, V::Set(C::Log2e)), Pow2n );
+				typename V::tType r = V::Sub( V::Sub(value, V::Mul(n, V::Set(C::Ln2Hi))), V::Mul(n, V::Set(C::Ln2Lo)) );
+				typename V::tType p = V::Set( tExpCoefficients<tType>::Value[Degree] );
+
+				for ( int k = Degree - 1; k >= 0; --k )
+					p = V::MulAdd( p, r, V::Set(tExpCoefficients<tType>::Value[k]) );
+
+				return V::Mul( p, Pow2n );
+			}
+
+			template <typename tType, typename tISA>
+			typename tVector<tType, tISA>::tType Exp( typename tVector<tType, tISA>::tType value, bool fastExp )
+			{
+				if ( fastExp )
+					return Exp< tType, tISA, tExpDegree<tType>::Fast >( value );
+
+				return Exp< tType, tISA, tExpDegree<tType>::Precise >( value );
+			}
+#endif // TOOLBOX_NEURALNETWORK_SIMD
+
+
+			//
+			// The kernels themselves -- Each has a scalar and (templated) vector version of the same math
+			//
+			struct tSigmoid
+			{
+				static const bool UsesExp = true;
+
+				template <typename tType>
+				static tType Scalar( tType value, bool fastExp )
+				{
+					return tType(1) / (tType(1) + Exp(-value, fastExp));
+				}
+
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+				template <typename tType, typename tISA>
+				static typename tVector<tType, tISA>::tType Vector( typename tVector<tType, tISA>::tType value, bool fastExp )
+				{
+					typedef tVector< tType, tISA >	V;
+					typename V::tType One = V::Set( tType(1) );
+					return V::Div( One, V::Add(One, Exp<tType, tISA>(V::Xor(value, V::Set(tType(-0.0))), fastExp)) );
+				}
+#endif
+			};
+
+			struct tFastSigmoid
+			{
+				static const bool UsesExp = false;
+
+				template <typename tType>
+				static tType Scalar( tType value, bool )
+				{
+					return value / (tType(1) + std::abs(value));
+				}
+
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+				template <typename tType, typename tISA>
+				static typename tVector<tType, tISA>::tType Vector( typename tVector<tType, tISA>::tType value, bool )
+				{
+					typedef tVector< tType, tISA >	V;
+					return V::Div( value, V::Add(V::Set(tType(1)), V::Abs(value)) );
+				}
+#endif
+			};
+
+			// tanh(x) = sign(x) * (1 - e) / (1 + e), where e = exp(-2|x|)
+			struct tTanH
+			{
+				static const bool UsesExp = true;
+
+				template <typename tType>
+				static tType Scalar( tType value, bool fastExp )
+				{
+					tType e = Exp( tType(-2) * std::abs(value), fastExp );
+					return std::copysign( (tType(1) - e) / (tType(1) + e), value );
+				}
+
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+				template <typename tType, typename tISA>
+				static typename tVector<tType, tISA>::tType Vector( typename tVector<tType, tISA>::tType value, bool fastExp )
+				{
+					typedef tVector< tType, tISA >	V;
+					typename V::tType One = V::Set( tType(1) );
+					typename V::tType e = Exp<tType, tISA>( V::Mul(V::Set(tType(-2)), V::Abs(value)), fastExp );
+					return V::Xor( V::Div(V::Sub(One, e), V::Add(One, e)), V::SignBits(value) );
+				}
+#endif
+			};
+
+			// Derivations operate on the activated value, just like their scalar counterparts
+			struct tSigmoidDerivation
+			{
+				static const bool UsesExp = false;
+
+				template <typename tType>
+				static tType Scalar( tType value, bool )
+				{
+					return value * (tType(1) - value);
+				}
+
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+				template <typename tType, typename tISA>
+				static typename tVector<tType, tISA>::tType Vector( typename tVector<tType, tISA>::tType value, bool )
+				{
+					typedef tVector< tType, tISA >	V;
+					return V::Mul( value, V::Sub(V::Set(tType(1)), value) );
+				}
+#endif
+			};
+
+			// sech^2(x) = 4e / (1 + e)^2, where e = exp(-2|x|)
+			struct tTanHDerivation
+			{
+				static const bool UsesExp = true;
+
+				template <typename tType>
+				static tType Scalar( tType value, bool fastExp )
+				{
+					tType e = Exp( tType(-2) * std::abs(value), fastExp );
+					tType d = tType(1) + e;
+					return (tType(4) * e) / (d * d);
+				}
+
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+				template <typename tType, typename tISA>
+				static typename tVector<tType, tISA>::tType Vector( typename tVector<tType, tISA>::tType value, bool fastExp )
+				{
+					typedef tVector< tType, tISA >	V;
+					typename V::tType e = Exp<tType, tISA>( V::Mul(V::Set(tType(-2)), V::Abs(value)), fastExp );
+					typename V::tType d = V::Add( V::Set(tType(1)), e );
+					return V::Div( V::Mul(V::Set(tType(4)), e), V::Mul(d, d) );
+				}
+#endif
+			};
+
+
+			// Runs a kernel over an entire array, using the widest vectors available
+			template <typename tKernel, typename tType>
+			void Run( const tType *values, tType *result, size_t count, bool fastExp )
+			{
+				size_t i = 0;
+
+#if defined(TOOLBOX_NEURALNETWORK_SIMD)
+				typedef tVector< tType, tBestISA >	V;
+
+				size_t VectorCount = count;
+
+				if ( tKernel::UsesExp && !fastExp && !tPreciseVector<tType>::Value )
+					VectorCount = 0;		// Fall straight through to the scalar loop (and the library exp())
+
+				// Branch once, so the compiler can specialize each loop
+				if ( fastExp )
+				{
+					for ( ; i + V::Width <= VectorCount; i += V::Width )
+						V::Store( result + i, tKernel::template Vector<tType, tBestISA>(V::Load(values + i), true) );
+				}
+				else
+				{
+					for ( ; i + V::Width <= VectorCount; i += V::Width )
+						V::Store( result + i, tKernel::template Vector<tType, tBestISA>(V::Load(values + i), false) );
+				}
+#endif
+
+				for ( ; i < count; ++i )
+					result[ i ] = tKernel::Scalar( values[i], fastExp );
+			}
+		}
+
+
+		//
+		// Batch Activation Functions
+		//
+		namespace Activation
+		{
+			// Any other tNeurotransmitter simply loops over the scalar functions
+			template <typename tType>
+			void Linear( const tType *values, tType *result, size_t count, bool fastExp = false )
+			{
+				if ( values != result )
+					std::copy( values, values + count, result );
+			}
+
+			template <typename tType>
+			void Sigmoid( const tType *values, tType *result, size_t count, bool fastExp = false )
+			{
+				for ( size_t i = 0; i < count; ++i )
+					result[ i ] = Sigmoid( values[i] );
+			}
+
+			template <typename tType>
+			void FastSigmoid( const tType *values, tType *result, size_t count, bool fastExp = false )
+			{
+				for ( size_t i = 0; i < count; ++i )
+					result[ i ] = FastSigmoid( values[i] );
+			}
+
+			template <typename tType>
+			void TanH( const tType *values, tType *result, size_t count, bool fastExp = false )
+			{
+				for ( size_t i = 0; i < count; ++i )
+					result[ i ] = TanH( values[i] );
+			}
+
+			inline void Sigmoid( const float *values, float *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tSigmoid >( values, result, count, fastExp );
+			}
+
+			inline void Sigmoid( const double *values, double *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tSigmoid >( values, result, count, fastExp );
+			}
+
+			inline void FastSigmoid( const float *values, float *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tFastSigmoid >( values, result, count, fastExp );
+			}
+
+			inline void FastSigmoid( const double *values, double *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tFastSigmoid >( values, result, count, fastExp );
+			}
+
+			inline void TanH( const float *values, float *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tTanH >( values, result, count, fastExp );
+			}
+
+			inline void TanH( const double *values, double *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tTanH >( values, result, count, fastExp );
+			}
+		}
+
+
+		//
+		// Batch Derivation Functions
+		//
+		namespace Derivation
+		{
+			template <typename tType>
+			void Linear( const tType *values, tType *result, size_t count, bool fastExp = false )
+			{
+				if ( values != result )
+					std::copy( values, values + count, result );
+			}
+
+			template <typename tType>
+			void Sigmoid( const tType *values, tType *result, size_t count, bool fastExp = false )
+			{
+				for ( size_t i = 0; i < count; ++i )
+					result[ i ] = Sigmoid( values[i] );
+			}
+
+			template <typename tType>
+			void FastSigmoid( const tType *values, tType *result, size_t count, bool fastExp = false )
+			{
+				Sigmoid( values, result, count, fastExp );
+			}
+
+			template <typename tType>
+			void TanH( const tType *values, tType *result, size_t count, bool fastExp = false )
+			{
+				for ( size_t i = 0; i < count; ++i )
+					result[ i ] = TanH( values[i] );
+			}
+
+			inline void Sigmoid( const float *values, float *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tSigmoidDerivation >( values, result, count, fastExp );
+			}
+
+			inline void Sigmoid( const double *values, double *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tSigmoidDerivation >( values, result, count, fastExp );
+			}
+
+			inline void FastSigmoid( const float *values, float *result, size_t count, bool fastExp = false )
+			{
+				Sigmoid( values, result, count, fastExp );
+			}
+
+			inline void FastSigmoid( const double *values, double *result, size_t count, bool fastExp = false )
+			{
+				Sigmoid( values, result, count, fastExp );
+			}
+
+			inline void TanH( const float *values, float *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tTanHDerivation >( values, result, count, fastExp );
+			}
+
+			inline void TanH( const double *values, double *result, size_t count, bool fastExp = false )
+			{
+				SIMD::Run< SIMD::tTanHDerivation >( values, result, count, fastExp );
+			}
+		}
+
+
+		// Each activation function, one value at a time and a whole layer at once -- Keeps tVectorizedNucleus<> from mixing up one with another
+		struct SigmoidKernel
+		{
+			template <typename tType>
+			static tType Activate( tType value )
+			{
+				return Activation::Sigmoid( value );
+			}
+
+			template <typename tType>
+			static tType Derive( tType value )
+			{
+				return Derivation::Sigmoid( value );
+			}
+
+			template <typename tType>
+			static void ActivateLayer( const tType *values, tType *result, size_t count, bool fastExp )
+			{
+				Activation::Sigmoid( values, result, count, fastExp );
+			}
+
+			template <typename tType>
+			static void DeriveLayer( const tType *values, tType *result, size_t count, bool fastExp )
+			{
+				Derivation::Sigmoid( values, result, count, fastExp );
+			}
+		};
+
+		struct FastSigmoidKernel
+		{
+			template <typename tType>
+			static tType Activate( tType value )
+			{
+				return Activation::FastSigmoid( value );
+			}
+
+			template <typename tType>
+			static tType Derive( tType value )
+			{
+				return Derivation::FastSigmoid( value );
+			}
+
+			template <typename tType>
+			static void ActivateLayer( const tType *values, tType *result, size_t count, bool fastExp )
+			{
+				Activation::FastSigmoid( values, result, count, fastExp );
+			}
+
+			template <typename tType>
+			static void DeriveLayer( const tType *values, tType *result, size_t count, bool fastExp )
+			{
+				Derivation::FastSigmoid( values, result, count, fastExp );
+			}
+		};
+
+		struct TanHKernel
+		{
+			template <typename tType>
+			static tType Activate( tType value )
+			{
+				return Activation::TanH( value );
+			}
+
+			template <typename tType>
+			static tType Derive( tType value )
+			{
+				return Derivation::TanH( value );
+			}
+
+			template <typename tType>
+			static void ActivateLayer( const tType *values, tType *result, size_t count, bool fastExp )
+			{
+				Activation::TanH( values, result, count, fastExp );
+			}
+
+			template <typename tType>
+			static void DeriveLayer( const tType *values, tType *result, size_t count, bool fastExp )
+			{
+				Derivation::TanH( values, result, count, fastExp );
+			}
+		};
+
+
+		// A nucleus whose per-neuron and whole-layer functions both come from _tKernel (final, so they can't be overridden apart)
+		template <typename _tNeurotransmitter = Default::tNeurotransmitter, typename _tKernel = SigmoidKernel>
+		class tVectorizedNucleus final : public tNucleus< _tNeurotransmitter >
+		{
+		public:
+			typedef _tNeurotransmitter				tNeurotransmitter;
+			typedef _tKernel						tKernel;
+			typedef tNucleus< tNeurotransmitter >	tParent;
+
+		public:
+			bool									FastExp;		// Use the fast exp() approximation for layers
+
+		public:
+			tVectorizedNucleus():
+				FastExp( false )
+			{
+			}
+
+			virtual tNeurotransmitter Activation( tNeurotransmitter value )
+			{
+				return tKernel::Activate( value );
+			}
+
+			virtual tNeurotransmitter Derivation( tNeurotransmitter value )
+			{
+				return tKernel::Derive( value );
+			}
+
+			virtual void ActivateLayer( const tNeurotransmitter *values, tNeurotransmitter *result, size_t count )
+			{
+				tKernel::ActivateLayer( values, result, count, FastExp );
+			}
+
+			virtual void DeriveLayer( const tNeurotransmitter *values, tNeurotransmitter *result, size_t count )
+			{
+				tKernel::DeriveLayer( values, result, count, FastExp );
+			}
+		};
+
+		typedef tVectorizedNucleus<>				VectorizedNucleus;
+		typedef tNeuron< VectorizedNucleus >		VectorizedNeuron;
+		typedef tVectorizedNucleus< float >		FloatVectorizedNucleus;
+		typedef tNeuron< FloatVectorizedNucleus >	FloatVectorizedNeuron;
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_VECTORIZED_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
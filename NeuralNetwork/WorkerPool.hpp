@@ -0,0 +1,215 @@
+#ifndef TOOLBOX_NEURALNETWORK_WORKERPOOL_HPP
+#define TOOLBOX_NEURALNETWORK_WORKERPOOL_HPP
+
+/*
+ * Toolbox/NeuralNetwork/WorkerPool.hpp
+ *
+ * A small, persistent pool of threads for splitting work into numbered tasks.
+ */
+
+
+/****************************************************************************
+ * Notes:
+ *
+ * - Run( count, task ) calls task( 0 ) ... task( count - 1 ), spread across
+ *   the pool, and returns once every one of them has finished.  The calling
+ *   thread works on tasks too, so a pool of N threads starts N - 1 of its
+ *   own.
+ *
+ * - Tasks are handed out in no particular order.  Anything that needs to be
+ *   deterministic should have each task write to its own slot (indexed by
+ *   the task number) and combine the slots in order afterwards.
+ *
+ * - The threads are started once and sleep between runs, so a pool can be
+ *   reused for many small runs (every mini-batch of a training session, for
+ *   example) without paying for thread creation each time.
+ *
+ * - Exceptions thrown by a task are caught, and the first one is rethrown
+ *   from Run() after the rest of the run has finished.
+ *
+ * - Programs using more than one thread must be linked with -pthread.
+ *
+ ****************************************************************************
+	Toolbox::NeuralNetwork::WorkerPool Pool( 8 );
+
+	std::vector< double > Results( 1000 );
+
+	Pool.Run( Results.size(), [&Results]( size_t task )
+		{
+			Results[ task ] = std::sqrt( double(task) );
+		} );
+
+ ****************************************************************************/
+/****************************************************************************/
+
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <Toolbox/Defines.h>
+
+
+namespace Toolbox
+{
+	namespace NeuralNetwork
+	{
+		class WorkerPool
+		{
+		public:
+			TOOLBOX_POINTERS( WorkerPool )
+
+			typedef std::function< void(size_t) >		tTask;
+
+		public:
+			WorkerPool( size_t numThreads = std::thread::hardware_concurrency() ):
+				_Task( NULL ),
+				_NumTasks( 0 ),
+				_NextTask( 0 ),
+				_Busy( 0 ),
+				_Generation( 0 ),
+				_Stopping( false )
+			{
+				// We're one of the threads
+				for ( size_t t = 1; t < numThreads; ++t )
+					_Threads.push_back( std::thread(&WorkerPool::_worker, this) );
+			}
+
+			virtual ~WorkerPool()
+			{
+				{
+					std::lock_guard< std::mutex > Lock( _Mutex );
+					_Stopping = true;
+				}
+
+				_Wake.notify_all();
+
+				for ( auto t = _Threads.begin(), t_end = _Threads.end(); t != t_end; ++t )
+					t->join();
+			}
+
+			// Including the calling thread
+			size_t NumThreads() const
+			{
+				return _Threads.size() + 1;
+			}
+
+			void Run( size_t numTasks, const tTask &task )
+			{
+				if ( numTasks == 0 )
+					return;
+
+				// Nothing to share, so don't bother waking anybody up
+				if ( _Threads.empty() || numTasks == 1 )
+				{
+					for ( size_t t = 0; t < numTasks; ++t )
+						task( t );
+
+					return;
+				}
+
+				{
+					std::lock_guard< std::mutex > Lock( _Mutex );
+
+					_Task = &task;
+					_NumTasks = numTasks;
+					_NextTask = 0;
+					_Busy = _Threads.size();
+					_Error = std::exception_ptr();
+					++_Generation;
+				}
+
+				_Wake.notify_all();
+				_runTasks();
+
+				// Wait for everyone else to finish up before letting go of the task
+				std::unique_lock< std::mutex > Lock( _Mutex );
+				_Done.wait( Lock, [this]() { return _Busy == 0; } );
+
+				_Task = NULL;
+
+				if ( _Error )
+				{
+					std::exception_ptr Error = _Error;
+					_Error = std::exception_ptr();
+					std::rethrow_exception( Error );
+				}
+			}
+
+		protected:
+			std::vector< std::thread >		_Threads;
+
+			std::mutex						_Mutex;
+			std::condition_variable			_Wake;			// Signals the threads that a new run has started (or that we're stopping)
+			std::condition_variable			_Done;			// Signals Run() that every thread has finished
+
+			const tTask						*_Task;
+			size_t							_NumTasks;
+			std::atomic< size_t >			_NextTask;
+			size_t							_Busy;			// How many threads are still working on the current run
+			size_t							_Generation;	// Counts runs, so a thread never works the same run twice
+			bool							_Stopping;
+			std::exception_ptr				_Error;
+
+		protected:
+			void _runTasks()
+			{
+				for ( size_t t = _NextTask++; t < _NumTasks; t = _NextTask++ )
+				{
+					try
+					{
+						(*_Task)( t );
+					}
+					catch ( ... )
+					{
+						std::lock_guard< std::mutex > Lock( _Mutex );
+
+						if ( !_Error )
+							_Error = std::current_exception();
+					}
+				}
+			}
+
+			void _worker()
+			{
+				size_t LastGeneration = 0;
+
+				while ( true )
+				{
+					{
+						std::unique_lock< std::mutex > Lock( _Mutex );
+						_Wake.wait( Lock, [this, LastGeneration]() { return _Stopping || _Generation != LastGeneration; } );
+
+						if ( _Stopping )
+							return;
+
+						LastGeneration = _Generation;
+					}
+
+					_runTasks();
+
+					bool LastOne = false;
+
+					{
+						std::lock_guard< std::mutex > Lock( _Mutex );
+						LastOne = (--_Busy == 0);
+					}
+
+					if ( LastOne )
+						_Done.notify_all();
+				}
+			}
+		};
+	}
+}
+
+
+#endif // TOOLBOX_NEURALNETWORK_WORKERPOOL_HPP
+
+
+// vim: tabstop=4 shiftwidth=4
+// astyle: --indent=tab=4 --style=ansi --indent-switches --indent-namespaces --pad-oper
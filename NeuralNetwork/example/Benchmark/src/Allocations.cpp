@@ -0,0 +1,93 @@
+/*
+ * Allocations.cpp
+ *
+ * Replaces the global operator new/delete (every form of them) so the
+ * benchmarks can count heap allocations.  Kept in its own file so the
+ * compiler doesn't inline these into the library's containers (GCC then
+ * mistakes the free() calls for a mismatched delete).
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Counting allocations
+//////////////////////////////////////////////////////////////////////////////
+std::atomic< size_t > NumAllocations( 0 );
+
+void *operator new( std::size_t size )
+{
+	++NumAllocations;
+
+	if ( void *Memory = std::malloc(size ? size : 1) )
+		return Memory;
+
+	throw std::bad_alloc();
+}
+
+void *operator new[]( std::size_t size )
+{
+	return operator new( size );
+}
+
+// Over-aligned types (std::aligned_alloc() needs the size to be a multiple of the alignment)
+void *operator new( std::size_t size, std::align_val_t alignment )
+{
+	++NumAllocations;
+
+	std::size_t Alignment = std::size_t( alignment );
+	std::size_t Size = ((size ? size : 1) + Alignment - 1) / Alignment * Alignment;
+
+	if ( void *Memory = std::aligned_alloc(Alignment, Size) )
+		return Memory;
+
+	throw std::bad_alloc();
+}
+
+void *operator new[]( std::size_t size, std::align_val_t alignment )
+{
+	return operator new( size, alignment );
+}
+
+void operator delete( void *memory ) noexcept
+{
+	std::free( memory );
+}
+
+void operator delete[]( void *memory ) noexcept
+{
+	std::free( memory );
+}
+
+void operator delete( void *memory, std::size_t ) noexcept
+{
+	operator delete( memory );
+}
+
+void operator delete[]( void *memory, std::size_t ) noexcept
+{
+	operator delete[]( memory );
+}
+
+void operator delete( void *memory, std::align_val_t ) noexcept
+{
+	std::free( memory );
+}
+
+void operator delete[]( void *memory, std::align_val_t ) noexcept
+{
+	std::free( memory );
+}
+
+void operator delete( void *memory, std::size_t, std::align_val_t alignment ) noexcept
+{
+	operator delete( memory, alignment );
+}
+
+void operator delete[]( void *memory, std::size_t, std::align_val_t alignment ) noexcept
+{
+	operator delete[]( memory, alignment );
+}
+//////////////////////////////////////////////////////////////////////////////
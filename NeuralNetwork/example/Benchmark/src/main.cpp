@@ -0,0 +1,624 @@
+/*
+ * main.cpp
+ *
+ * Benchmarks for Toolbox::NeuralNetwork
+ *
+ * Builds a fixed set of fully-connected and recurrent networks (with seeded
+ * weights, so every run works on exactly the same networks), times them, and
+ * writes the results out as JSON:
+ *
+ *   - Process() latency (mean and percentiles) and passes per second
+ *   - Compiled ProcessBatch() records per second
+ *   - Trainer::Train() epochs (and records) per second
+ *   - Heap allocations per pass/record/epoch
+ *
+ * Usage: benchmark [--sizes tiny,small,medium,large,xlarge] [--float] [--budget <seconds>] [--output <file.json>]
+ *
+ *   --sizes    Which sizes to run (all of them by default)
+ *   --float    Use float networks instead of double
+ *   --budget   Roughly how long to spend on each measurement (0.5 seconds by default)
+ *   --output   Where to write the JSON (stdout by default) -- Progress always goes to stderr
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <Toolbox/NeuralNetwork/Recurrent.hpp>
+#include <Toolbox/NeuralNetwork/RecurrentTrainer.hpp>
+#include <Toolbox/NeuralNetwork/Trainer.hpp>
+#include <Toolbox/NeuralNetwork/Vectorized.hpp>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Counting allocations (every form of new counts, see Allocations.cpp)
+//////////////////////////////////////////////////////////////////////////////
+extern std::atomic< size_t > NumAllocations;
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Typedefs, variable definitions, etc.
+//////////////////////////////////////////////////////////////////////////////
+typedef std::chrono::steady_clock	tClock;
+
+const unsigned int	Seed				= 5489;		// Weights, inputs and targets all come from this
+const size_t		BatchRecords		= 1024;		// Records per compiled ProcessBatch()
+const size_t		SequenceLength		= 16;		// Passes per recurrent training sequence
+const size_t		MaxLatencyPasses	= 100000;
+
+// Every network is fully connected, layer to layer
+struct tTopology
+{
+	std::string		Size;
+	size_t			Inputs;
+	size_t			HiddenLayers;
+	size_t			HiddenWidth;
+	size_t			Outputs;
+	bool			Recurrent;
+	size_t			TrainingRecords;	// Records per training epoch (fewer for the big ones, so an epoch fits in a sensible time)
+};
+
+const tTopology Topologies[] =
+{
+	// Size		In		Hidden		Width	Out		Recurrent	Records
+	{ "tiny",	2,		1,			3,		1,		false,		64 },
+	{ "small",	16,		1,			32,		4,		false,		64 },
+	{ "medium",	64,		2,			128,	16,		false,		64 },
+	{ "large",	256,	3,			512,	64,		false,		16 },
+	{ "xlarge",	512,	32,			288,	256,	false,		4 },		// ~10k neurons (kept narrow so it fits in memory)
+
+	{ "tiny",	2,		1,			3,		1,		true,		64 },
+	{ "small",	16,		1,			32,		4,		true,		64 },
+	{ "medium",	64,		2,			128,	16,		true,		64 },
+	{ "large",	256,	2,			512,	64,		true,		16 },
+};
+
+struct tOptions
+{
+	std::vector< std::string >	Sizes;
+	bool						Float;
+	double						Budget;		// Seconds
+	std::string					Output;
+
+	tOptions():
+		Sizes( { "tiny", "small", "medium", "large", "xlarge" } ),
+		Float( false ),
+		Budget( 0.5 )
+	{
+	}
+};
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Helpers
+//////////////////////////////////////////////////////////////////////////////
+double Seconds( tClock::time_point start, tClock::time_point end = tClock::now() )
+{
+	return std::chrono::duration< double >( end - start ).count();
+}
+
+// Zero-padded, so the labels (and therefore the columns) sort in creation order
+std::string Label( const char *prefix, size_t index )
+{
+	std::ostringstream Result;
+	Result << prefix << ' ';
+	Result.width( 6 );
+	Result.fill( '0' );
+	Result << index;
+	return Result.str();
+}
+
+template <typename tNetwork>
+void Build( tNetwork &network, const tTopology &topology )
+{
+	for ( size_t i = 0; i < topology.Inputs; ++i )
+		network.NewInput( Label("Input", i) );
+
+	for ( size_t h = 0; h < topology.HiddenLayers; ++h )
+		network.NewHiddenLayer( topology.HiddenWidth );
+
+	for ( size_t o = 0; o < topology.Outputs; ++o )
+		network.NewOutput( Label("Output", o) );
+
+	network.ConnectNetwork();
+}
+
+// Recurrent neurons also have memory weights
+template <typename tNeuron, typename = void>
+struct tHasMemory : std::false_type
+{
+};
+
+template <typename tNeuron>
+struct tHasMemory< tNeuron, std::void_t<decltype(std::declval<tNeuron &>().MemoryWeight)> > : std::true_type
+{
+};
+
+// ConnectNetwork() picks random weights -- Replace them with seeded ones, visiting the neurons in a fixed order
+template <typename tNeuron, typename tRandom>
+void SeedNeuron( tNeuron &neuron, tRandom &random )
+{
+	typedef typename tNeuron::tNeurotransmitter T;
+	std::uniform_real_distribution< double > Weight( -0.75, 0.75 );
+
+	for ( auto d = neuron.Dendrites.begin(), d_end = neuron.Dendrites.end(); d != d_end; ++d )
+		d->second = T( Weight(random) );
+
+	if constexpr ( tHasMemory<tNeuron>::value )
+	{
+		for ( auto m = neuron.MemoryWeight.begin(), m_end = neuron.MemoryWeight.end(); m != m_end; ++m )
+			*m = T( Weight(random) * 0.1 );
+	}
+}
+
+template <typename tNetwork>
+void SeedWeights( tNetwork &network )
+{
+	std::mt19937 Random( Seed );
+
+	for ( auto l = network.Hidden.begin(), l_end = network.Hidden.end(); l != l_end; ++l )
+	{
+		for ( auto n = l->second.begin(), n_end = l->second.end(); n != n_end; ++n )
+			SeedNeuron( *n->second, Random );
+	}
+
+	for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
+		SeedNeuron( *o->second, Random );
+}
+
+template <typename T>
+std::vector< T > RandomValues( size_t count, double min, double max, unsigned int seed )
+{
+	std::mt19937 Random( seed );
+	std::uniform_real_distribution< double > Value( min, max );
+	std::vector< T > Result( count );
+
+	for ( auto v = Result.begin(), v_end = Result.end(); v != v_end; ++v )
+		*v = T( Value(Random) );
+
+	return Result;
+}
+
+double Percentile( const std::vector<double> &sorted, double percent )
+{
+	if ( sorted.empty() )
+		return 0.0;
+
+	return sorted[ std::min(sorted.size() - 1, size_t(percent / 100.0 * double(sorted.size()))) ];
+}
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// A minimal JSON writer (just what we need)
+//////////////////////////////////////////////////////////////////////////////
+class tJSON
+{
+public:
+	tJSON():
+		_First( true )
+	{
+	}
+
+	void Open( const std::string &name = std::string(), char bracket = '{' )
+	{
+		_key( name );
+		_Out << bracket;
+		_First = true;
+	}
+
+	void Close( char bracket = '}' )
+	{
+		_Out << bracket;
+		_First = false;
+	}
+
+	void Value( const std::string &name, const std::string &value )
+	{
+		_key( name );
+		_Out << '"' << value << '"';
+	}
+
+	void Value( const std::string &name, double value )
+	{
+		_key( name );
+		_Out << value;
+	}
+
+	void Value( const std::string &name, size_t value )
+	{
+		_key( name );
+		_Out << value;
+	}
+
+	void Value( const std::string &name, bool value )
+	{
+		_key( name );
+		_Out << (value ? "true" : "false");
+	}
+
+	std::string Str() const
+	{
+		return _Out.str() + "\n";
+	}
+
+protected:
+	std::ostringstream	_Out;
+	bool				_First;
+
+protected:
+	void _key( const std::string &name )
+	{
+		if ( !_First )
+			_Out << ',';
+
+		_First = false;
+
+		if ( !name.empty() )
+			_Out << '"' << name << "\":";
+	}
+};
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// The measurements themselves
+//////////////////////////////////////////////////////////////////////////////
+
+// Times single Process() passes, each with new inputs
+template <typename tNetwork>
+void MeasureProcess( tJSON &json, tNetwork &network, double budget )
+{
+	typedef typename tNetwork::tNeurotransmitter T;
+
+	const size_t NumIn = network.Input.size();
+	const size_t NumRecords = 256;
+	std::vector< T > Inputs = RandomValues< T >( NumRecords * NumIn, 0.0, 1.0, Seed + 1 );
+	std::vector< typename tNetwork::ttLabeledNeuron::Ptr > InputNeurons;
+
+	for ( auto i = network.Input.begin(), i_end = network.Input.end(); i != i_end; ++i )
+		InputNeurons.push_back( i->second );
+
+	std::vector< double > Latency;
+	Latency.reserve( MaxLatencyPasses );
+
+	auto SetInputs = [&]( size_t pass )
+	{
+		const T *Record = Inputs.data() + ((pass % NumRecords) * NumIn);
+
+		for ( size_t i = 0; i < NumIn; ++i )
+			InputNeurons[ i ]->SetValue( Record[i] );
+	};
+
+	// Warm up (builds the processing schedule, etc.)
+	SetInputs( 0 );
+	network.Process();
+
+	size_t Allocations = 0;
+	auto Start = tClock::now();
+
+	for ( size_t p = 0; p < MaxLatencyPasses && (p < 10 || Seconds(Start) < budget); ++p )
+	{
+		SetInputs( p );
+
+		size_t Before = NumAllocations;
+		auto PassStart = tClock::now();
+		network.Process();
+		auto PassEnd = tClock::now();
+		Allocations += NumAllocations - Before;
+
+		Latency.push_back( std::chrono::duration<double, std::micro>(PassEnd - PassStart).count() );
+	}
+
+	double Total = 0.0;
+
+	for ( auto l = Latency.begin(), l_end = Latency.end(); l != l_end; ++l )
+		Total += *l;
+
+	std::vector< double > Sorted( Latency );
+	std::sort( Sorted.begin(), Sorted.end() );
+
+	json.Open( "process" );
+	json.Value( "passes", Latency.size() );
+	json.Value( "mean_us", Total / double(Latency.size()) );
+	json.Value( "p50_us", Percentile(Sorted, 50.0) );
+	json.Value( "p90_us", Percentile(Sorted, 90.0) );
+	json.Value( "p99_us", Percentile(Sorted, 99.0) );
+	json.Value( "max_us", Sorted.back() );
+	json.Value( "passes_per_sec", double(Latency.size()) / (Total * 1e-6) );
+	json.Value( "allocations_per_pass", double(Allocations) / double(Latency.size()) );
+	json.Close();
+}
+
+// Compiled, batched inference
+template <typename tNetwork>
+void MeasureBatch( tJSON &json, const tNetwork &network, double budget )
+{
+	typedef typename tNetwork::tNeurotransmitter T;
+
+	auto Compiled = network.Compile();
+	std::vector< T > Inputs = RandomValues< T >( BatchRecords * network.Input.size(), 0.0, 1.0, Seed + 2 );
+	std::vector< T > Outputs;
+
+	Compiled.ProcessBatch( Inputs, Outputs );		// Warm up (and size Outputs)
+
+	size_t Batches = 0;
+	size_t Allocations = NumAllocations;
+	auto Start = tClock::now();
+
+	do
+	{
+		Compiled.ProcessBatch( Inputs, Outputs );
+		++Batches;
+	} while ( Seconds(Start) < budget );
+
+	double Elapsed = Seconds( Start );
+	Allocations = NumAllocations - Allocations;
+
+	json.Open( "compiled_batch" );
+	json.Value( "records", Batches * BatchRecords );
+	json.Value( "records_per_sec", double(Batches * BatchRecords) / Elapsed );
+	json.Value( "allocations_per_record", double(Allocations) / double(Batches * BatchRecords) );
+	json.Close();
+}
+
+// Incremental training -- AllowedError is zero, so every epoch runs
+template <typename tNetwork, typename tTrainer>
+void MeasureTraining( tJSON &json, tNetwork &network, tTrainer &trainer, size_t recordsPerEpoch, double budget )
+{
+	typedef typename tNetwork::tNeurotransmitter T;
+
+	Toolbox::NeuralNetwork::tTrainingSet< tNetwork > Set( network );
+	std::vector< T > Inputs = RandomValues< T >( recordsPerEpoch * Set.NumInputs(), 0.0, 1.0, Seed + 3 );
+	std::vector< T > Targets = RandomValues< T >( recordsPerEpoch * Set.NumOutputs(), 0.1, 0.9, Seed + 4 );
+
+	Set.Reserve( recordsPerEpoch );
+
+	for ( size_t r = 0; r < recordsPerEpoch; ++r )
+		Set.AddRecord( Inputs.data() + (r * Set.NumInputs()), Targets.data() + (r * Set.NumOutputs()) );
+
+	trainer.AllowedError = T();
+	trainer.MaxTrainingCycles = 1;
+
+	// One epoch first, to see how many fit in the budget
+	auto Start = tClock::now();
+	trainer.Train( network, Set );
+	double Once = Seconds( Start );
+
+	size_t Epochs = std::max< size_t >( 1, std::min<size_t>(1000, size_t(budget / std::max(Once, 1e-9))) );
+	trainer.MaxTrainingCycles = Epochs;
+
+	size_t Allocations = NumAllocations;
+	Start = tClock::now();
+	trainer.Train( network, Set );
+	double Elapsed = Seconds( Start );
+	Allocations = NumAllocations - Allocations;
+
+	json.Open( "train" );
+	json.Value( "records_per_epoch", recordsPerEpoch );
+	json.Value( "epochs", Epochs );
+	json.Value( "epochs_per_sec", double(Epochs) / Elapsed );
+	json.Value( "records_per_sec", double(Epochs * recordsPerEpoch) / Elapsed );
+	json.Value( "allocations_per_epoch", double(Allocations) / double(Epochs) );
+	json.Close();
+}
+
+// Whole sequences at once (see tRecurrent<>::ProcessSequence())
+template <typename tNetwork>
+void MeasureSequence( tJSON &json, tNetwork &network, double budget )
+{
+	typedef typename tNetwork::tNeurotransmitter T;
+
+	const size_t NumPasses = 32;
+	std::vector< T > Inputs = RandomValues< T >( NumPasses * network.Input.size(), 0.0, 1.0, Seed + 5 );
+	std::vector< T > Outputs;
+
+	network.ProcessSequence( Inputs, Outputs );		// Warm up
+
+	size_t Sequences = 0;
+	size_t Allocations = NumAllocations;
+	auto Start = tClock::now();
+
+	do
+	{
+		network.ProcessSequence( Inputs, Outputs );
+		++Sequences;
+	} while ( Seconds(Start) < budget );
+
+	double Elapsed = Seconds( Start );
+	Allocations = NumAllocations - Allocations;
+
+	json.Open( "sequence" );
+	json.Value( "passes", Sequences * NumPasses );
+	json.Value( "passes_per_sec", double(Sequences * NumPasses) / Elapsed );
+	json.Value( "allocations_per_pass", double(Allocations) / double(Sequences * NumPasses) );
+	json.Close();
+}
+
+template <typename tNetwork>
+void Describe( tJSON &json, const tNetwork &network, const tTopology &topology, double buildSeconds )
+{
+	size_t Neurons = network.Input.size() + network.Output.size();
+	size_t Connections = 0;
+
+	for ( auto l = network.Hidden.begin(), l_end = network.Hidden.end(); l != l_end; ++l )
+	{
+		Neurons += l->second.size();
+
+		for ( auto n = l->second.begin(), n_end = l->second.end(); n != n_end; ++n )
+			Connections += n->second->Dendrites.size();
+	}
+
+	for ( auto o = network.Output.begin(), o_end = network.Output.end(); o != o_end; ++o )
+		Connections += o->second->Dendrites.size();
+
+	json.Value( "name", std::string(topology.Recurrent ? "recurrent-" : "feedforward-") + topology.Size );
+	json.Value( "kind", std::string(topology.Recurrent ? "recurrent" : "feedforward") );
+	json.Value( "size", topology.Size );
+
+	json.Open( "layers", '[' );
+	json.Value( "", topology.Inputs );
+
+	for ( size_t h = 0; h < topology.HiddenLayers; ++h )
+		json.Value( "", topology.HiddenWidth );
+
+	json.Value( "", topology.Outputs );
+	json.Close( ']' );
+
+	json.Value( "neurons", Neurons );
+	json.Value( "connections", Connections );
+	json.Value( "build_sec", buildSeconds );
+}
+
+template <typename tNetwork, typename tTrainer>
+void Run( tJSON &json, const tTopology &topology, double budget )
+{
+	auto Start = tClock::now();
+	tNetwork Network;
+	Build( Network, topology );
+	SeedWeights( Network );
+	double BuildSeconds = Seconds( Start );
+
+	json.Open();
+	Describe( json, Network, topology, BuildSeconds );
+
+	MeasureProcess( json, Network, budget );
+
+	if constexpr ( std::is_same<tTrainer, Toolbox::NeuralNetwork::tTrainer<tNetwork>>::value )
+	{
+		MeasureBatch( json, Network, budget );
+
+		tTrainer Trainer;
+		MeasureTraining( json, Network, Trainer, topology.TrainingRecords, budget );
+	}
+	else
+	{
+		MeasureSequence( json, Network, budget );
+
+		tTrainer Trainer;
+		Trainer.SequenceLength = SequenceLength;
+		Trainer.LearningRate = 0.03;
+		MeasureTraining( json, Network, Trainer, topology.TrainingRecords, budget );
+	}
+
+	json.Close();
+}
+
+template <typename tNucleus>
+void RunAll( tJSON &json, const tOptions &options )
+{
+	typedef Toolbox::NeuralNetwork::tNeuron< tNucleus >						tFeedforwardNeuron;
+	typedef Toolbox::NeuralNetwork::tGanglion< tFeedforwardNeuron >			tFeedforward;
+	typedef Toolbox::NeuralNetwork::tRecurrentNucleus< typename tNucleus::tNeurotransmitter >	tRecurrentNucleus;
+	typedef Toolbox::NeuralNetwork::tRecurrentNeuron< tRecurrentNucleus >	tRecurrentNeuron;
+	typedef Toolbox::NeuralNetwork::tRecurrent< tRecurrentNeuron::MemorySize, tRecurrentNeuron >	tRecurrent;
+
+	json.Open( "results", '[' );
+
+	for ( auto &Topology : Topologies )
+	{
+		if ( std::find(options.Sizes.begin(), options.Sizes.end(), Topology.Size) == options.Sizes.end() )
+			continue;
+
+		std::cerr << (Topology.Recurrent ? "recurrent-" : "feedforward-") << Topology.Size << "..." << std::endl;
+
+		if ( Topology.Recurrent )
+			Run< tRecurrent, Toolbox::NeuralNetwork::tRecurrentTrainer<tRecurrent> >( json, Topology, options.Budget );
+		else
+			Run< tFeedforward, Toolbox::NeuralNetwork::tTrainer<tFeedforward> >( json, Topology, options.Budget );
+	}
+
+	json.Close( ']' );
+}
+
+tOptions ParseOptions( int argc, char *argv[] )
+{
+	tOptions Options;
+
+	for ( int a = 1; a < argc; ++a )
+	{
+		std::string Arg( argv[a] );
+
+		if ( Arg == "--float" )
+			Options.Float = true;
+		else if ( Arg == "--sizes" && a + 1 < argc )
+		{
+			Options.Sizes.clear();
+			std::istringstream Sizes( argv[++a] );
+
+			for ( std::string Size; std::getline(Sizes, Size, ','); )
+				Options.Sizes.push_back( Size );
+		}
+		else if ( Arg == "--budget" && a + 1 < argc )
+			Options.Budget = std::stod( argv[++a] );
+		else if ( Arg == "--output" && a + 1 < argc )
+			Options.Output = argv[ ++a ];
+		else
+			throw std::runtime_error( "Usage: " + std::string(argv[0]) + " [--sizes tiny,small,medium,large,xlarge] [--float] [--budget <seconds>] [--output <file.json>]" );
+	}
+
+	return Options;
+}
+//////////////////////////////////////////////////////////////////////////////
+
+
+int main( int argc, char *argv[] )
+{
+	try
+	{
+		tOptions Options = ParseOptions( argc, argv );
+		tJSON JSON;
+
+		JSON.Open();
+		JSON.Value( "benchmark", std::string("Toolbox::NeuralNetwork") );
+		JSON.Value( "compiler", std::string(__VERSION__) );
+#if defined(__AVX2__) && defined(TOOLBOX_NEURALNETWORK_SIMD)
+		JSON.Value( "simd", std::string("AVX2") );
+#elif defined(TOOLBOX_NEURALNETWORK_SIMD)
+		JSON.Value( "simd", std::string("SSE2") );
+#else
+		JSON.Value( "simd", std::string("none") );
+#endif
+		JSON.Value( "neurotransmitter", std::string(Options.Float ? "float" : "double") );
+		JSON.Value( "hardware_threads", size_t(std::thread::hardware_concurrency()) );
+		JSON.Value( "seed", size_t(Seed) );
+		JSON.Value( "budget_sec", Options.Budget );
+
+		if ( Options.Float )
+			RunAll< Toolbox::NeuralNetwork::FloatNucleus >( JSON, Options );
+		else
+			RunAll< Toolbox::NeuralNetwork::Nucleus >( JSON, Options );
+
+		JSON.Close();
+
+		if ( Options.Output.empty() )
+			std::cout << JSON.Str();
+		else
+		{
+			std::ofstream File( Options.Output );
+
+			if ( !File )
+				throw std::runtime_error( "Unable to open '" + Options.Output + "' for writing." );
+
+			File << JSON.Str();
+		}
+	}
+	catch ( std::exception &ex )
+	{
+		std::cerr << "Fatal error: " << ex.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -1,14 +1,14 @@
 /*
  * main.cpp
  *
- * A (NOT) working example for Toolbox::NeuralNetwork::Recurrent
+ * A working example for Toolbox::NeuralNetwork::Recurrent
  */
 
 #include <iostream>
 #include <stdexcept>
 
 #include <Toolbox/NeuralNetwork/Recurrent.hpp>
-#include <Toolbox/NeuralNetwork/Trainer.hpp>
+#include <Toolbox/NeuralNetwork/RecurrentTrainer.hpp>
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -71,19 +71,17 @@ void PrintNeuron( typename _tNeuron::Ptr neuron, unsigned int indent_spaces = 2
 
 	if ( RecurrentMemory )
 	{
-		std::cout << Indent << "Memory (" << RecurrentMemory->Memory.size() << "): ";
+		std::cout << Indent << "Memory (" << RecurrentMemory->MemoryCount() << "): ";
 
 		bool First = true;
-		for ( auto m = RecurrentMemory->Memory.begin(), m_end = RecurrentMemory->Memory.end();
-			  m != m_end;
-			  ++m )
+		for ( size_t m = 0, m_end = RecurrentMemory->MemoryCount(); m < m_end; ++m )
 		{
 			if ( !First )
 				std::cout << ", ";
 
 			First = false;
 
-			std::cout << *m;
+			std::cout << RecurrentMemory->Memory( m );
 		}
 
 		std::cout << std::endl;
@@ -263,7 +261,8 @@ int main( int argc, char *argv[] )
 		//
 		// Train the network
 		//
-		tTrainer< ttRecurrent > Backprop;
+		tRecurrentTrainer< ttRecurrent > Backprop;	// Trains the memory weights too (the whole set is one sequence, by default)
+		Backprop.LearningRate = 0.03;
 
 		double Error = 0;						// This allows us to get our optional error return parameter so we know exactly how trained our network is
 		size_t NumCycles = 0;					// This allows us to get our optional count of how many cycles it took our network to train
@@ -292,6 +291,7 @@ int main( int argc, char *argv[] )
 		// Manual Testing
 		//
 		std::cout << "  Manual validation of XOR dataset (allows for visualization too):" << std::endl;
+		XORNet->ClearMemory();					// The network was trained on the set as a sequence, so start it over from the beginning
 		XORNet->SetInput( "Input 1", OFF );
 		XORNet->SetInput( "Input 2", OFF );
 		XORNet->Process();